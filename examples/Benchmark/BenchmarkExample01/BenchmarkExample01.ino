@@ -0,0 +1,160 @@
+// BenchmarkExample01.ino
+// Microbenchmark of the Motor and Spinner hot paths defined by the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The library must be built with the symbol TB6612FNG_BENCHMARK defined
+// (for instance, build_flags = -DTB6612FNG_BENCHMARK in PlatformIO)
+#include <tb6612fng.h>
+
+#if !defined(TB6612FNG_BENCHMARK)
+#error "BenchmarkExample01 requires the library to be built with TB6612FNG_BENCHMARK defined"
+#endif
+
+#define DOUT1 2  // Arduino digital IO
+#define DOUT2 3  // Arduino digital IO
+#define PWMOUT 4 // Arduino digital IO with PWM feature
+
+#define CALLS 1000 // Calls performed by every benchmark
+
+Motor *motor;
+Spinner *spinner;
+SpinPoint spinMap[2];
+CompiledSpinSegment compiledSegments[2];
+CompiledSpinMap compiledSpinMap(compiledSegments, 2);
+
+// Prints the figures of a benchmark
+void report(const char *name, unsigned long elapsedMicros, uint32_t pinWrites, uint32_t floatOps)
+{
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print((elapsedMicros * 1000.0) / CALLS);
+    Serial.print(" ns/call, ");
+    Serial.print((float)pinWrites / CALLS);
+    Serial.print(" pin writes/call, ");
+    Serial.print((float)floatOps / CALLS);
+    Serial.println(" float ops/call");
+}
+
+// Resets the benchmark counters
+void resetCounters()
+{
+    halBenchmark.pinWrites = 0;
+    halBenchmark.floatOps = 0;
+}
+
+void benchmarkStart()
+{
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+        spinner->start(Clockwise, spinMap);
+    report("Spinner::start()", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkSpin()
+{
+    // Advance the fake clock one millisecond per call,
+    // so every call interpolates and sets a new speed
+    halBenchmark.clock = 0;
+    spinner->start(Clockwise, spinMap);
+
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+    {
+        halBenchmark.clock += 1000;
+        spinner->spin();
+    }
+    report("Spinner::spin()", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkCompiledStart()
+{
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+        spinner->start(Clockwise, &compiledSpinMap);
+    report("Spinner::start() compiled", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkCompiledSpin()
+{
+    halBenchmark.clock = 0;
+    spinner->start(Clockwise, &compiledSpinMap);
+
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+    {
+        halBenchmark.clock += 1000;
+        spinner->spin();
+    }
+    report("Spinner::spin() compiled", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkRun()
+{
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+        motor->run(Clockwise, 1 + i * 64);
+    report("Motor::run()", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkStop()
+{
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+        motor->stop();
+    report("Motor::stop()", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void benchmarkBrake()
+{
+    resetCounters();
+    unsigned long begin = micros();
+    for (int i = 0; i < CALLS; i++)
+        motor->brake();
+    report("Motor::brake()", micros() - begin, halBenchmark.pinWrites, halBenchmark.floatOps);
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Replace the clock and the pins by the benchmark stand-in:
+    // the library reads a clock driven by this sketch
+    // and the motor outputs are recorded instead of being driven
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+    spinner = new Spinner(motor);
+
+    // Ramp long enough to change the speed on every benchmarked millisecond
+    spinMap[0].time = 0;
+    spinMap[0].speed = 1;
+    spinMap[1].time = 60000;
+    spinMap[1].speed = 65535;
+    compiledSpinMap.compile(spinMap, 2, Milliseconds);
+
+    benchmarkStart();
+    benchmarkSpin();
+    benchmarkCompiledStart();
+    benchmarkCompiledSpin();
+    benchmarkRun();
+    benchmarkStop();
+    benchmarkBrake();
+}
+
+void loop()
+{
+}
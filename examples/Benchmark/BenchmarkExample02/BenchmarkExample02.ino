@@ -0,0 +1,117 @@
+// BenchmarkExample02.ino
+// Closed loop velocity control of a simulated motor with the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The library must be built with the symbol TB6612FNG_BENCHMARK defined
+// (for instance, build_flags = -DTB6612FNG_BENCHMARK in PlatformIO)
+#include <tb6612fng.h>
+
+#if !defined(TB6612FNG_BENCHMARK)
+#error "BenchmarkExample02 requires the library to be built with TB6612FNG_BENCHMARK defined"
+#endif
+
+#define DOUT1 2  // Arduino digital IO
+#define DOUT2 3  // Arduino digital IO
+#define PWMOUT 4 // Arduino digital IO with PWM feature
+#define ENCA 5   // Arduino digital IO
+#define ENCB 6   // Arduino digital IO
+
+#define MAX_COUNTS_PER_SECOND 4000 // Encoder counts per second at full speed
+#define CONTROL_PERIOD 10          // Control period, in milliseconds
+#define SIMULATION_STEP 100        // Simulation step, in microseconds
+
+Motor *motor;
+VelocityController *controller;
+HalMotorPlant plant;
+
+// Simulated encoder interrupt service routines
+void encoderA()
+{
+    controller->encoderEdgeA();
+}
+
+void encoderB()
+{
+    controller->encoderEdgeB();
+}
+
+// Simulates the motor for a given time, running the controller
+void simulate(unsigned long milliseconds)
+{
+    for (unsigned long i = 0; i < milliseconds * 1000 / SIMULATION_STEP; i++)
+    {
+        halBenchmark.clock += SIMULATION_STEP;
+        halPlantStep(&plant, SIMULATION_STEP);
+        controller->update();
+    }
+}
+
+// Prints the steady state velocity reached by the simulated motor
+void report(const char *name, uint16_t setpoint)
+{
+    Serial.print(name);
+    Serial.print(": setpoint ");
+    Serial.print(setpoint);
+    Serial.print(", measured velocity ");
+    Serial.print(controller->velocity());
+    Serial.print(", simulated velocity ");
+    Serial.println((long)((long long)plant.velocity * 65535 / 1000 / MAX_COUNTS_PER_SECOND));
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Replace the clock and the pins by the benchmark stand-in:
+    // the motor outputs drive the simulated motor, whose encoder drives the controller
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    EncoderPinMap encoderPinMap;
+    encoderPinMap.a = ENCA;
+    encoderPinMap.b = ENCB;
+    controller = new VelocityController(motor, &encoderPinMap, MAX_COUNTS_PER_SECOND, CONTROL_PERIOD);
+    controller->tune(128, 64, 0);
+
+    // Simulated motor with a time constant of 50 milliseconds, loaded with 30% of its free speed
+    plant.in1 = DOUT1;
+    plant.in2 = DOUT2;
+    plant.pwm = PWMOUT;
+    plant.encoderA = ENCA;
+    plant.encoderB = ENCB;
+    plant.encoderAISR = encoderA;
+    plant.encoderBISR = encoderB;
+    plant.freeSpeed = MAX_COUNTS_PER_SECOND;
+    plant.timeConstant = 50;
+    plant.load = 19660;
+
+    // Open loop: the load slows down the motor
+    motor->run(Clockwise, 32768);
+    simulate(1000);
+    controller->update();
+    report("Open loop", 32768);
+
+    // Closed loop: the controller compensates the load
+    controller->run(Clockwise, 32768);
+    simulate(1000);
+    report("Closed loop", 32768);
+
+    controller->run(CounterClockwise, 16384);
+    simulate(1000);
+    report("Closed loop, reversed", 16384);
+
+    controller->stop();
+}
+
+void loop()
+{
+}
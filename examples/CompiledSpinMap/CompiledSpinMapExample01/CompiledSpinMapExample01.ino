@@ -0,0 +1,53 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+
+Motor *motor;
+Spinner *spinner;
+
+// Spin map accelerating the motor from stopped to 80% of its max speed in 3000 milliseconds,
+// keeping that speed for 2000 milliseconds, and then deccelerating it until stopped in 3000 milliseconds
+SpinPoint spinMap[4] = {{0, 0}, {52428, 3000}, {52428, 5000}, {0, 8000}};
+
+// Curves of the three map segments
+uint8_t segmentCurves[3] = {SCurve, Linear, SCurve};
+
+// Compiled map, with a compiled segment per spin map point
+CompiledSpinSegment compiledSegments[4];
+CompiledSpinMap compiledSpinMap(compiledSegments, 4);
+
+// Callback function for the spinner event of spin finished
+// Starts the compiled map again, with no slope calculation
+void spinFinished(const SpinPoint *spinPoint)
+{
+    spinner->start(Clockwise, &compiledSpinMap);
+}
+
+void setup()
+{
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+
+    // Compile the spin map once, for the spinner timebase
+    compiledSpinMap.compile(spinMap, 4, segmentCurves, Milliseconds);
+
+    // Start spinning the motor in clockwise direction
+    spinner->start(Clockwise, &compiledSpinMap);
+}
+
+void loop()
+{
+    // Spin the motor: calling spin() every millisecond, every speed update just adds the segment slope
+    spinner->spin();
+}
@@ -0,0 +1,66 @@
+// MotorExample03.ino
+// Usage example of the class Motor defined by the Arduino TB6612FNG Toshiba driver Library
+// using an ultrasonic PWM frequency generated by the 16-bit Timer1 of an AVR based Arduino Uno
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define DOUT1 7  // Arduino Uno digital out 7
+#define DOUT2 8  // Arduino Uno digital out 8
+#define PWMOUT 9 // Arduino Uno digital out 9, output A of Timer1
+#define LED 13   // Arduino Uno digital out 13 (connected to the builtin led)
+
+Motor *motor;
+uint32_t speed;
+
+void setup()
+{
+    Serial.begin(9600);
+
+    // Declare and initialize the pin mapping
+    // for interfacing the driver motor A
+    PinMap pinMap;
+
+    pinMap.in1 = DOUT1;  // Arduino DOUT1 output is connected to driver AIN1 input
+    pinMap.in2 = DOUT2;  // Arduino DOUT2 output is connected to driver AIN2 input
+    pinMap.pwm = PWMOUT; // Arduino PWMOUT output is connected to driver PWMA input
+
+    // Create a Motor object instance
+    // being controlled with a custom PWM signal of 20kHz, out of the audible range
+    motor = new Motor(&pinMap, 20000);
+
+    // The motor falls back to analogWrite if the PWM pin has no 16-bit timer
+    if (motor->pwmBackend() == NULL)
+        Serial.println("Custom PWM frequency not set");
+
+    // At 20kHz the Timer1 of a 16MHz Arduino offers 400 duty cycle steps,
+    // instead of the 255 steps of analogWrite
+    Serial.print("PWM resolution: ");
+    Serial.println(motor->pwmResolution());
+
+    pinMode(LED, OUTPUT);
+    speed = 1;
+}
+
+void loop()
+{
+    if (speed <= 65535)
+    {
+        // Run the motor clockwise at current speed
+        motor->run(Direction::Clockwise, speed);
+
+        // Spin up to full speed in about 20 secs.,
+        // every speed change increasing the duty cycle by a single step
+        delay(50);
+        speed += 164;
+    }
+    else
+    {
+        // Full speed reached: Stop the motor
+        motor->stop();
+
+        // Light the led to indicate that the process is finished
+        digitalWrite(LED, HIGH);
+    }
+}
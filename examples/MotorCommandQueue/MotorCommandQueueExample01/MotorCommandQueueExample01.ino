@@ -0,0 +1,55 @@
+// MotorCommandQueueExample01.ino
+// Usage example of the class MotorCommandQueue defined by the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define AOUT1 2   // Arduino digital IO
+#define AOUT2 4   // Arduino digital IO
+#define APWMOUT 5 // Arduino digital IO with PWM feature
+#define LED 13    // Arduino digital IO connected to the builtin led
+
+#define COMMANDS 8 // Queue buffer size
+
+MotorCommandQueue *queue;
+MotorCommand commands[COMMANDS];
+unsigned long ledTime;
+
+void setup()
+{
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+    ledTime = millis();
+
+    // Create a Motor object instance and its command queue
+    PinMap pinMap;
+    pinMap.in1 = AOUT1;
+    pinMap.in2 = AOUT2;
+    pinMap.pwm = APWMOUT;
+    queue = new MotorCommandQueue(new Motor(&pinMap), commands, COMMANDS);
+}
+
+void loop()
+{
+    // Queue the sequence again once it's done. Every delay is counted from the time
+    // of the previous command, so the late loop updates don't delay the sequence
+    if (queue->available() == 0)
+    {
+        queue->brake(1000);
+        queue->run(CounterClockwise, 26214, 20);
+        queue->stop(500);
+        queue->run(Clockwise, 26214, 1000);
+        queue->stop(500);
+    }
+
+    // Execute the due motor commands
+    queue->update();
+
+    // Blink the led, the motor sequence doesn't block the loop
+    if (millis() - ledTime >= 100)
+    {
+        ledTime += 100;
+        digitalWrite(LED, !digitalRead(LED));
+    }
+}
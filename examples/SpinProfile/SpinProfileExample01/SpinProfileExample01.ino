@@ -0,0 +1,41 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+
+Motor *motor;
+Spinner *spinner;
+
+// Pump duty cycle: the pump is primed at 30% of its max speed for 5 seconds, then it spins up to 80%
+// in 2 seconds, keeps that speed for 2 minutes and spins down until stopped in 2 seconds.
+// It's then kept stopped for 3 minutes before looping back to the spin up
+LongSpinPoint pumpPoints[6] = {{19661, 0}, {19661, 5000}, {52428, 7000}, {52428, 127000}, {0, 129000}, {0, 309000}};
+
+// Pump profile, looping back to its third point (the end of the priming)
+SpinProfile pumpProfile(pumpPoints, 6);
+
+void setup()
+{
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    spinner = new Spinner(motor);
+
+    // Loop the pump cycle forever, from the end of the priming.
+    // The cycles are spun back-to-back, with no start() call between them
+    pumpProfile.loop(1, SPIN_LOOP_FOREVER);
+    spinner->start(Clockwise, &pumpProfile);
+}
+
+void loop()
+{
+    // Spin the pump
+    spinner->spin();
+}
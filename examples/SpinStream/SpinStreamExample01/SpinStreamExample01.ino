@@ -0,0 +1,112 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+#define LED 13    // Arduino digital IO connected to the builtin led
+
+Motor *motor;
+Spinner *spinner;
+
+// Stream of up to 15 spin points, filled with the points received through the serial port
+SpinPoint streamBuffer[16];
+SpinStream stream(streamBuffer, 16);
+bool spinning = false;
+
+// Serial line being received, and its parsed point
+char line[16];
+uint8_t lineLength = 0;
+uint16_t lineSpeed, lineTime;
+bool linePending = false;
+
+// Reads a serial line with format "speed time", or "end"
+// Returns true once a line is completely received
+bool readLine()
+{
+    while (Serial.available() > 0)
+    {
+        char c = Serial.read();
+        if (c != '\n')
+        {
+            if (lineLength < sizeof(line) - 1)
+                line[lineLength++] = c;
+            continue;
+        }
+
+        line[lineLength] = 0;
+        lineLength = 0;
+        return true;
+    }
+    return false;
+}
+
+// Callback function for the spinner event of spin finished
+// This function will be invoked when the last point of the closed stream was reached
+void spinFinished(const SpinPoint *spinPoint)
+{
+    // Report the stream health and get ready for the next stream
+    Serial.print("Finished. Underruns: ");
+    Serial.print(stream.underruns());
+    Serial.print(", low-water mark: ");
+    Serial.println(stream.lowWaterMark());
+    stream.reset();
+    spinning = false;
+    digitalWrite(LED, LOW);
+}
+
+void setup()
+{
+    // Initialize the led output and the serial port
+    pinMode(LED, OUTPUT);
+    Serial.begin(115200);
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+}
+
+void loop()
+{
+    // Parse a new line once the previous one was appended to the stream
+    if (!linePending && readLine())
+    {
+        if (strcmp(line, "end") == 0)
+        {
+            // The host sent the last point: close the stream
+            stream.close();
+        }
+        else
+        {
+            char *timeText;
+            lineSpeed = strtoul(line, &timeText, 10);
+            lineTime = strtoul(timeText, NULL, 10);
+            linePending = true;
+        }
+    }
+
+    // Append the received point as soon as the stream has room for it.
+    // A point with a zero time increment is rejected, and then dropped
+    if (linePending && stream.space() > 0)
+    {
+        stream.append(lineSpeed, lineTime);
+        linePending = false;
+
+        // Start spinning once the stream holds a few points
+        if (!spinning && stream.available() >= 4)
+        {
+            spinning = spinner->start(Clockwise, &stream) != NULL;
+            digitalWrite(LED, HIGH);
+        }
+    }
+
+    // Spin the motor
+    spinner->spin();
+}
@@ -0,0 +1,74 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+#define LED 13    // Arduino digital IO connected to the builtin led
+
+Motor *motor;
+Spinner *spinner;
+
+// Spin map stored in flash memory, accelerating the motor from 40% to 80% of its max speed
+// in 10000 milliseconds, and then deccelerating it until stopped in 30000 milliseconds
+const SpinPoint spinMap[] PROGMEM = {{26214, 0}, {52428, 10000}, {0, 40000}};
+
+// Packed spin map stored in flash memory, pulsing the motor speed around 40% of its max speed
+// Every pulse point takes 2 bytes, and the last point, with a big speed increment, takes 5 bytes
+const uint8_t packedSpinMap[] PROGMEM = {
+    SPIN_PACKED_START(26214),
+    SPIN_PACKED_DELTA(250, 127),
+    SPIN_PACKED_DELTA(250, -127),
+    SPIN_PACKED_DELTA(250, 127),
+    SPIN_PACKED_DELTA(250, -127),
+    SPIN_PACKED_DELTA(250, 127),
+    SPIN_PACKED_DELTA(250, -127),
+    SPIN_PACKED_POINT(5000, 0)};
+const uint8_t packedSpinMapSize = 8;
+
+bool packedSpinStarted = false;
+
+// Callback function for the spinner event of spin finished
+// This function will be invoked when the last point of the spin map was reached
+void spinFinished(const SpinPoint *spinPoint)
+{
+    if (!packedSpinStarted)
+    {
+        // The flash spin map has concluded: start the packed one
+        packedSpinStarted = true;
+        spinner->startPacked(CounterClockwise, packedSpinMap, packedSpinMapSize);
+    }
+    else
+    {
+        // Both spin processes have concluded
+        // Light the led
+        digitalWrite(LED, HIGH);
+    }
+}
+
+void setup()
+{
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+
+    // Start spinning up the motor in clockwise direction
+    // The spin map is read from flash memory, so it doesn't take any RAM
+    spinner->startFlash(Clockwise, spinMap, 3);
+}
+
+void loop()
+{
+    // Spin the motor
+    spinner->spin();
+}
@@ -0,0 +1,53 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+#define LED 13    // Arduino digital IO connected to the builtin led
+
+Motor *motor;
+Spinner *spinner;
+
+// Spin map accelerating the motor from stopped to 80% of its max speed in 3000 milliseconds,
+// keeping that speed for 5000 milliseconds, and then deccelerating it until stopped in 3000 milliseconds
+SpinPoint spinMap[4] = {{0, 0}, {52428, 3000}, {52428, 8000}, {0, 11000}};
+
+// Curves of the three map segments: the acceleration and the decceleration
+// start and end smoothly, without the speed steps of a linear spin
+uint8_t segmentCurves[3] = {SCurve, Linear, SCurve};
+
+// Callback function for the spinner event of spin finished
+// This function will be invoked when the last point of the spin map was reached
+void spinFinished(const SpinPoint *spinPoint)
+{
+    // The spin process has concluded
+    // Light the led
+    digitalWrite(LED, HIGH);
+}
+
+void setup()
+{
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+
+    // Start spinning the motor in clockwise direction, following the segment curves
+    spinner->start(Clockwise, spinMap, 4, segmentCurves);
+}
+
+void loop()
+{
+    // Spin the motor
+    spinner->spin();
+}
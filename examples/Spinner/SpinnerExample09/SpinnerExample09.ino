@@ -0,0 +1,83 @@
+// The library must be built with the symbol TB6612FNG_SPIN_STATS defined
+// (for instance, build_flags = -DTB6612FNG_SPIN_STATS in PlatformIO)
+#include <tb6612fng.h>
+
+#if !defined(TB6612FNG_SPIN_STATS)
+#error "SpinnerExample09 requires the library to be built with TB6612FNG_SPIN_STATS defined"
+#endif
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+
+Motor *motor;
+Spinner *spinner;
+
+// Spin map accelerating the motor from stopped to 80% of its max speed in 3000 milliseconds,
+// keeping that speed for 2000 milliseconds, and then deccelerating it until stopped in 3000 milliseconds
+SpinPoint spinMap[4] = {{0, 0}, {52428, 3000}, {52428, 5000}, {0, 8000}};
+
+// Callback function for the spinner event of spin updated
+// Printing every speed through the serial port delays the next spin() calls
+void spinUpdated(const SpinPoint *spinPoint)
+{
+    Serial.println(spinPoint->speed);
+}
+
+// Callback function for the spinner event of spin finished
+// Prints the timing statistics of the spin
+void spinFinished(const SpinPoint *spinPoint)
+{
+    SpinStats stats;
+    spinner->stats(&stats);
+
+    Serial.print("spin() calls: ");
+    Serial.println(stats.calls);
+    Serial.print("Interval min/avg/max (ms): ");
+    Serial.print(stats.minInterval);
+    Serial.print("/");
+    Serial.print(stats.intervalSum / stats.calls);
+    Serial.print("/");
+    Serial.println(stats.maxInterval);
+    Serial.print("Interval histogram:");
+    for (uint8_t bin = 0; bin < SPIN_STATS_BINS; bin++)
+    {
+        Serial.print(" ");
+        Serial.print(stats.intervalHistogram[bin]);
+    }
+    Serial.println();
+    Serial.print("Late updates: ");
+    Serial.println(stats.skippedSteps);
+    Serial.print("Time in spin() / callbacks (us): ");
+    Serial.print(stats.spinTime);
+    Serial.print(" / ");
+    Serial.println(stats.callbackTime);
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using callback functions for handling its events
+    spinner = new Spinner(motor, spinUpdated, spinFinished);
+
+    // Start spinning the motor in clockwise direction
+    spinner->start(Clockwise, spinMap, 4);
+}
+
+void loop()
+{
+    // Spin the motor
+    spinner->spin();
+}
@@ -0,0 +1,62 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+
+Motor *motor;
+Spinner *spinner;
+
+// Slow spin map accelerating the motor from stopped to 20% of its max speed in 30 seconds,
+// and then deccelerating it until stopped in another 30 seconds
+SpinPoint spinMap[3] = {{0, 0}, {13107, 30000}, {0, 60000}};
+
+// Number of spin() calls
+unsigned long spinCalls = 0;
+
+// Callback function for the spinner event of spin finished
+void spinFinished(const SpinPoint *spinPoint)
+{
+    Serial.print("Spin finished with ");
+    Serial.print(spinCalls);
+    Serial.println(" spin() calls");
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+
+    // Start spinning the motor in clockwise direction
+    spinner->start(Clockwise, spinMap, 3);
+}
+
+void loop()
+{
+    // Spin the motor
+    spinner->spin();
+    spinCalls++;
+
+    // Wait until the next speed change, instead of calling spin() again right now.
+    // A battery powered board could sleep meanwhile
+    unsigned long dueTime;
+    if (spinner->nextUpdateDue(&dueTime))
+    {
+        long wait = (long)(dueTime - millis());
+        if (wait > 0)
+            delay(wait);
+    }
+}
@@ -0,0 +1,56 @@
+#include <tb6612fng.h>
+
+#define DOUT1 20  // Arduino digital IO
+#define DOUT2 21  // Arduino digital IO
+#define PWMOUT 19 // Arduino digital IO with PWM feature
+
+Motor *motor;
+Spinner *spinner;
+
+// Signed spin map oscillating the motor: 50% of its max speed forward for a second,
+// then reversing it to 50% backwards in 2 seconds, and back to 50% forward in another 2 seconds.
+// The motor crosses zero speed twice, 2 and 4 seconds after the spin start
+SignedSpinPoint spinMap[4] = {{16384, 0}, {16384, 1000}, {-16384, 3000}, {16384, 5000}};
+
+// Callback function for the spinner event of spin finished
+void spinFinished(const SpinPoint *spinPoint)
+{
+    // Spin points of signed maps hold the signed velocity
+    Serial.print("Spin finished at velocity ");
+    Serial.println(((const SignedSpinPoint *)spinPoint)->velocity);
+
+    // Start the oscillation again
+    spinner->start(Clockwise, spinMap, 4);
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create a spinner object instance associated to motor
+    // using only one callback function for handling the event of spin finished
+    spinner = new Spinner(motor, NULL, spinFinished);
+
+    // Short-brake the motor for 100ms on every zero crossing,
+    // so that it's stopped before driving it in the opposite direction
+    spinner->zeroSpeed(Brake, 100);
+
+    // Start spinning the motor, clockwise being the direction of the positive velocities
+    spinner->start(Clockwise, spinMap, 4);
+}
+
+void loop()
+{
+    // Spin the motor
+    spinner->spin();
+}
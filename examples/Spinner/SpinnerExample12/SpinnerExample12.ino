@@ -0,0 +1,77 @@
+#include <tb6612fng.h>
+
+#define AOUT1 2   // Arduino digital IO
+#define AOUT2 4   // Arduino digital IO
+#define APWMOUT 5 // Arduino digital IO with PWM feature
+#define BOUT1 7   // Arduino digital IO
+#define BOUT2 8   // Arduino digital IO
+#define BPWMOUT 9 // Arduino digital IO with PWM feature
+
+// Data of every spinned motor, passed as context to the callbacks
+struct Axis
+{
+    const char *name;
+    Spinner *spinner;
+};
+
+Axis axes[2] = {{"A", NULL}, {"B", NULL}};
+
+// Spin map accelerating from stopped to max speed in 2 seconds
+// and then decelerating until stopping in 2 seconds
+SpinPoint spinMap[3] = {{0, 0}, {65535, 2000}, {0, 4000}};
+
+// Callback function for the spinner event of spin updated, shared by both motors.
+// Its calls are decimated by the spinners, so the serial writes don't delay the speed updates
+void spinUpdated(void *context, const SpinPoint *spinPoint)
+{
+    Axis *axis = (Axis *)context;
+    Serial.print(axis->name);
+    Serial.print(" speed ");
+    Serial.print(spinPoint->speed);
+    Serial.print(" at ");
+    Serial.println(spinPoint->time);
+}
+
+// Callback function for the spinner event of spin finished, shared by both motors
+void spinFinished(void *context, const SpinPoint *spinPoint)
+{
+    Axis *axis = (Axis *)context;
+    Serial.print(axis->name);
+    Serial.println(" finished");
+
+    // Start the motor again
+    axis->spinner->start(Clockwise, spinMap, 3);
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    while (!Serial)
+        ;
+
+    // Create a spinner for every motor, passing its axis as callback context
+    PinMap pinMap;
+    pinMap.in1 = AOUT1;
+    pinMap.in2 = AOUT2;
+    pinMap.pwm = APWMOUT;
+    axes[0].spinner = new Spinner(new Motor(&pinMap), spinUpdated, spinFinished, &axes[0]);
+    pinMap.in1 = BOUT1;
+    pinMap.in2 = BOUT2;
+    pinMap.pwm = BPWMOUT;
+    axes[1].spinner = new Spinner(new Motor(&pinMap), spinUpdated, spinFinished, &axes[1]);
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        // Raise the spin updated event at most every 250ms,
+        // and only if the speed changed by 5% of the max speed at least
+        axes[i].spinner->updateFilter(250, 3277);
+        axes[i].spinner->start(Clockwise, spinMap, 3);
+    }
+}
+
+void loop()
+{
+    // Spin both motors
+    axes[0].spinner->spin();
+    axes[1].spinner->spin();
+}
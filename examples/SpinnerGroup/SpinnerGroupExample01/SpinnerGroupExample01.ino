@@ -0,0 +1,69 @@
+// SpinnerGroupExample01.ino
+// Usage example of the class SpinnerGroup defined by the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define AOUT1 2   // Arduino digital IO
+#define AOUT2 4   // Arduino digital IO
+#define APWMOUT 5 // Arduino digital IO with PWM feature
+#define BOUT1 7   // Arduino digital IO
+#define BOUT2 8   // Arduino digital IO
+#define BPWMOUT 9 // Arduino digital IO with PWM feature
+#define LED 13    // Arduino digital IO connected to the builtin led
+
+Spinner *leftWheel, *rightWheel;
+SpinPoint spinMap[3];
+
+// Callback function for the group event of group finished,
+// called once both wheels are stopped
+void groupFinished()
+{
+    digitalWrite(LED, HIGH);
+}
+
+SpinnerGroup wheels(Milliseconds, groupFinished);
+
+void setup()
+{
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+
+    // Create a Spinner object instance for every wheel motor
+    PinMap pinMap;
+    pinMap.in1 = AOUT1;
+    pinMap.in2 = AOUT2;
+    pinMap.pwm = APWMOUT;
+    leftWheel = new Spinner(new Motor(&pinMap));
+    pinMap.in1 = BOUT1;
+    pinMap.in2 = BOUT2;
+    pinMap.pwm = BPWMOUT;
+    rightWheel = new Spinner(new Motor(&pinMap));
+
+    // Group both spinners
+    wheels.add(leftWheel);
+    wheels.add(rightWheel);
+
+    // Define a spin map accelerating from stopped to 80% of max speed in 5 seconds
+    // and then decelerating until stopping in 5 seconds
+    spinMap[0].time = 0;
+    spinMap[0].speed = 0;
+    spinMap[1].time = 5000;
+    spinMap[1].speed = 52428;
+    spinMap[2].time = 10000;
+    spinMap[2].speed = 0;
+
+    // Start both wheels, mounted facing each other, so that the robot moves forward.
+    // The group moves both spin starts to the same time reference
+    leftWheel->start(Clockwise, spinMap, 3);
+    rightWheel->start(CounterClockwise, spinMap, 3);
+    wheels.start();
+}
+
+void loop()
+{
+    // Spin both wheels with a single clock read,
+    // setting both motor speeds back-to-back
+    wheels.spin();
+}
@@ -0,0 +1,84 @@
+// SpinnerSchedulerExample01.ino
+// Usage example of the class SpinnerScheduler defined by the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define AOUT1 2  // Arduino digital IO
+#define AOUT2 4  // Arduino digital IO
+#define APWMOUT 5 // Arduino digital IO with PWM feature
+#define BOUT1 7  // Arduino digital IO
+#define BOUT2 8  // Arduino digital IO
+#define BPWMOUT 9 // Arduino digital IO with PWM feature
+#define LED 13   // Arduino digital IO connected to the builtin led
+
+Spinner *spinnerA, *spinnerB;
+SpinPoint spinMap[3];
+uint8_t finishedSpinners;
+
+// The scheduler spins both spinners from the Timer0 compare interrupt
+SpinnerScheduler scheduler;
+TB6612FNG_SCHEDULER_ISR(scheduler)
+
+// Callback function for the spinner event of spin finished
+// Though the spinners are spun from an interrupt,
+// this function is called from the main loop by scheduler.dispatch()
+void spinFinished(const SpinPoint *spinPoint)
+{
+    finishedSpinners++;
+    if (finishedSpinners == 2)
+    {
+        // Both spin processes have concluded: Light the led
+        digitalWrite(LED, HIGH);
+    }
+}
+
+void setup()
+{
+    Serial.begin(9600);
+
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+
+    // Create a Spinner object instance for every driver motor
+    PinMap pinMap;
+    pinMap.in1 = AOUT1;
+    pinMap.in2 = AOUT2;
+    pinMap.pwm = APWMOUT;
+    spinnerA = new Spinner(new Motor(&pinMap), NULL, spinFinished);
+    pinMap.in1 = BOUT1;
+    pinMap.in2 = BOUT2;
+    pinMap.pwm = BPWMOUT;
+    spinnerB = new Spinner(new Motor(&pinMap), NULL, spinFinished);
+
+    // Add the spinners to the scheduler and start ticking it
+    scheduler.add(spinnerA);
+    scheduler.add(spinnerB);
+    scheduler.begin();
+
+    // Define a spin map accelerating from 40% to 80% of max speed in 10 seconds
+    // and then decelerating until stopping in 30 seconds
+    spinMap[0].time = 0;
+    spinMap[0].speed = 26214;
+    spinMap[1].time = 10000;
+    spinMap[1].speed = 52428;
+    spinMap[2].time = 40000;
+    spinMap[2].speed = 0;
+
+    // Start spinning both motors in opposite directions
+    finishedSpinners = 0;
+    spinnerA->start(Clockwise, spinMap, 3);
+    spinnerB->start(CounterClockwise, spinMap, 3);
+}
+
+void loop()
+{
+    // Call the spinner callbacks, if any event was raised
+    scheduler.dispatch();
+
+    // The loop can be slow without affecting the spin quality:
+    // the spinners are spun from the timer interrupt
+    Serial.println("Doing other stuff");
+    delay(100);
+}
@@ -0,0 +1,74 @@
+// StepperExample01.ino
+// Usage example of the class Stepper defined by the Arduino TB6612FNG Toshiba driver Library
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define AOUT1 2    // Arduino digital IO
+#define AOUT2 4    // Arduino digital IO
+#define APWMOUT 9  // Arduino digital IO with PWM feature (Timer1 output)
+#define BOUT1 7    // Arduino digital IO
+#define BOUT2 8    // Arduino digital IO
+#define BPWMOUT 10 // Arduino digital IO with PWM feature (Timer1 output)
+#define LED 13     // Arduino digital IO connected to the builtin led
+
+Stepper *stepper;
+SpinPoint rampMap[4];
+
+// The stepper is stepped from the Timer2 compare interrupt
+TB6612FNG_STEPPER_ISR(*stepper)
+
+void setup()
+{
+    Serial.begin(9600);
+
+    // Initialize the led output
+    pinMode(LED, OUTPUT);
+
+    // Create a Motor object instance for every motor coil.
+    // Both PWM outputs are generated by Timer1 at 20kHz, so the coil currents are not audible
+    PinMap pinMap;
+    pinMap.in1 = AOUT1;
+    pinMap.in2 = AOUT2;
+    pinMap.pwm = APWMOUT;
+    Motor *coilA = new Motor(&pinMap, 20000);
+    pinMap.in1 = BOUT1;
+    pinMap.in2 = BOUT2;
+    pinMap.pwm = BPWMOUT;
+    Motor *coilB = new Motor(&pinMap, 20000);
+
+    // Create a Stepper object instance driving the motor in eighth steps
+    // and start ticking it 20000 times per second
+    stepper = new Stepper(coilA, coilB, EighthStep);
+    stepper->begin(20000);
+
+    // Define a ramp accelerating from 0 to 4000 eighth steps per second
+    // (2.5 revolutions per second of a 200 steps per revolution motor) in 2 seconds,
+    // keeping that step rate for 5 seconds and then decelerating until stopping in 2 seconds
+    rampMap[0].time = 0;
+    rampMap[0].speed = 0;
+    rampMap[1].time = 2000;
+    rampMap[1].speed = 4000;
+    rampMap[2].time = 7000;
+    rampMap[2].speed = 4000;
+    rampMap[3].time = 9000;
+    rampMap[3].speed = 0;
+
+    stepper->start(Clockwise, rampMap, 4);
+}
+
+void loop()
+{
+    // The loop can be slow without affecting the step timing:
+    // the motor is stepped from the timer interrupt
+    Serial.println(stepper->position());
+    delay(100);
+
+    if (!stepper->ramping())
+    {
+        // Ramp concluded: Release the motor and light the led
+        stepper->release();
+        digitalWrite(LED, HIGH);
+    }
+}
@@ -0,0 +1,69 @@
+#include <tb6612fng.h>
+
+#define DOUT1 4   // Arduino digital IO
+#define DOUT2 5   // Arduino digital IO
+#define PWMOUT 6  // Arduino digital IO with PWM feature
+#define ENCA 2    // Arduino digital IO with external interrupt, connected to the encoder channel A
+#define ENCB 3    // Arduino digital IO with external interrupt, connected to the encoder channel B
+
+#define MAX_COUNTS_PER_SECOND 4000 // Encoder counts per second at full speed
+#define CONTROL_PERIOD 10          // Control period, in milliseconds
+
+Motor *motor;
+VelocityController *controller;
+Spinner *spinner;
+
+// Spin map accelerating the motor from stopped to half its max speed in 2000 milliseconds,
+// and then deccelerating it until stopped in 2000 milliseconds
+SpinPoint spinMap[3] = {{0, 0}, {32768, 2000}, {0, 4000}};
+
+// Encoder interrupt service routines
+void encoderA()
+{
+    controller->encoderEdgeA();
+}
+
+void encoderB()
+{
+    controller->encoderEdgeB();
+}
+
+void setup()
+{
+    Serial.begin(115200);
+
+    // Create a Motor object instance
+    // (pinMap pins are initialized by the Motor class)
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    motor = new Motor(&pinMap);
+
+    // Create the motor velocity controller and attach the encoder interrupts
+    EncoderPinMap encoderPinMap;
+    encoderPinMap.a = ENCA;
+    encoderPinMap.b = ENCB;
+    controller = new VelocityController(motor, &encoderPinMap, MAX_COUNTS_PER_SECOND, CONTROL_PERIOD);
+    controller->tune(128, 64, 0);
+    attachInterrupt(digitalPinToInterrupt(ENCA), encoderA, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(ENCB), encoderB, CHANGE);
+
+    // Create a spinner object instance associated to the controller:
+    // the spin map speeds are the controller velocity setpoints
+    spinner = new Spinner(controller);
+    spinner->start(Clockwise, spinMap, 3);
+}
+
+void loop()
+{
+    // Update the velocity setpoint and run the control steps
+    const SpinPoint *spinPoint = spinner->spin();
+    if (controller->update() && spinPoint != NULL)
+    {
+        // Print the setpoint and the measured velocity
+        Serial.print(spinPoint->speed);
+        Serial.print(" ");
+        Serial.println(controller->velocity());
+    }
+}
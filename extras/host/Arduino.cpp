@@ -0,0 +1,79 @@
+// Arduino.cpp
+// Implementation of the host stand-in of the Arduino core
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "Arduino.h"
+
+#include <time.h>
+
+HostSerial Serial;
+
+// Value last written to every pin
+static int pins[NUM_DIGITAL_PINS];
+
+void pinMode(pin_size_t, uint8_t)
+{
+}
+
+void digitalWrite(pin_size_t pin, uint8_t value)
+{
+    if (pin < NUM_DIGITAL_PINS)
+        pins[pin] = value;
+}
+
+int digitalRead(pin_size_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? pins[pin] : LOW;
+}
+
+void analogWrite(pin_size_t pin, int value)
+{
+    if (pin < NUM_DIGITAL_PINS)
+        pins[pin] = value;
+}
+
+/**
+ * Returns the host monotonic clock
+ * @returns {unsigned long long} Clock value, in nanoseconds
+ */
+static unsigned long long clockNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Clock value when the program started, the Arduino time origin
+static unsigned long long startNanos = clockNanos();
+
+unsigned long millis()
+{
+    return (unsigned long)((clockNanos() - startNanos) / 1000000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)((clockNanos() - startNanos) / 1000);
+}
+
+/**
+ * Waits for a given time, spinning on the host clock
+ * @param {unsigned long long} nanos - Waited time, in nanoseconds
+ */
+static void waitNanos(unsigned long long nanos)
+{
+    unsigned long long end = clockNanos() + nanos;
+    while (clockNanos() < end)
+        ;
+}
+
+void delay(unsigned long ms)
+{
+    waitNanos((unsigned long long)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    waitNanos((unsigned long long)us * 1000);
+}
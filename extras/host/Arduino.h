@@ -0,0 +1,75 @@
+// Arduino.h
+// Host stand-in of the Arduino core, for building the library and its benchmarks on Linux
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Only the part of the Arduino API used by the library and its benchmarks is provided.
+// Pins are plain variables and the clock is the host monotonic clock
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define NUM_DIGITAL_PINS 32
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+typedef uint8_t pin_size_t;
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+void pinMode(pin_size_t pin, uint8_t mode);
+void digitalWrite(pin_size_t pin, uint8_t value);
+int digitalRead(pin_size_t pin);
+void analogWrite(pin_size_t pin, int value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/**
+ * Serial port stand-in, printing to the standard output
+ * @class
+ */
+class HostSerial
+{
+public:
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+
+    size_t print(const char *value) { return printf("%s", value); }
+    size_t print(char value) { return printf("%c", value); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t print(unsigned int value) { return printf("%u", value); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(double value) { return printf("%.2f", value); }
+
+    template <typename T>
+    size_t println(T value) { return print(value) + printf("\n"); }
+    size_t println() { return printf("\n"); }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,14 @@
+// main.cpp
+// Host entry point running an Arduino sketch once
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The sketch file is set by the build through the SKETCH symbol
+#include SKETCH
+
+int main()
+{
+    setup();
+    loop();
+    return 0;
+}
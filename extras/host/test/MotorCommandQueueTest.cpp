@@ -0,0 +1,239 @@
+// MotorCommandQueueTest.cpp
+// Motor command queue test: checks the execution times of relative and absolute commands
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define SEQUENCES 2000   // Random command sequences run on every timebase
+#define MAX_COMMANDS 16  // Max commands of a random sequence
+#define QUEUE_SIZE 5     // Queue buffer size, holding up to QUEUE_SIZE - 1 commands
+
+/**
+ * Motor recording every operation, and the clock at which it was done
+ * @class
+ */
+class RecordingMotor : public MotorInterface
+{
+public:
+    int count = 0;
+    unsigned long time = 0;
+    char action = ' ';
+    Direction direction = Clockwise;
+    uint16_t speed = 0;
+
+    void run(Direction runDirection, uint16_t runSpeed) override
+    {
+        record('r');
+        direction = runDirection;
+        speed = runSpeed;
+    }
+
+    void stop() override
+    {
+        record('s');
+    }
+
+    void brake() override
+    {
+        record('b');
+    }
+
+private:
+    void record(char recordedAction)
+    {
+        count++;
+        time = halBenchmark.clock;
+        action = recordedAction;
+    }
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Checks a condition, printing the first failures
+static void check(bool condition, const char *test, const char *message)
+{
+    if (condition || failures++ >= 10)
+        return;
+
+    printf("%s: %s\n", test, message);
+}
+
+// Sets the fake clock to a time in milliseconds and updates the queue
+static bool updateAt(MotorCommandQueue *queue, unsigned long time)
+{
+    halBenchmark.clock = time * 1000;
+    return queue->update();
+}
+
+// Runs a relative sequence updated every 7 milliseconds: every command is executed at the first update
+// after its time, and the update latency doesn't delay the next commands
+static void testRelativeSequence()
+{
+    RecordingMotor motor;
+    MotorCommand buffer[QUEUE_SIZE];
+    MotorCommandQueue queue(&motor, buffer, QUEUE_SIZE);
+
+    halBenchmark.clock = 0;
+    queue.run(Clockwise, 1000, 100);
+    queue.stop(100);
+    queue.brake(100);
+    queue.run(CounterClockwise, 2000, 100);
+    check(!queue.brake(100), "Relative sequence", "command queued in a full queue");
+    check(queue.available() == 4 && queue.space() == 0, "Relative sequence", "wrong queued commands count");
+
+    const unsigned long expectedTimes[] = {105, 203, 301, 406};
+    const char expectedActions[] = {'r', 's', 'b', 'r'};
+    int executed = 0;
+    for (unsigned long time = 0; time <= 420; time += 7)
+    {
+        updateAt(&queue, time);
+        if (motor.count == executed)
+            continue;
+
+        check(motor.count == executed + 1, "Relative sequence", "several commands executed by an update");
+        check(motor.time == expectedTimes[executed] * 1000 && motor.action == expectedActions[executed],
+              "Relative sequence", "command executed at a wrong time");
+        executed = motor.count;
+    }
+    check(executed == 4 && motor.direction == CounterClockwise && motor.speed == 2000, "Relative sequence", "last command not executed");
+    check(queue.available() == 0, "Relative sequence", "queue not empty");
+}
+
+// Runs absolute commands, late and in the past: a command is never executed before the previous ones
+static void testAbsoluteCommands()
+{
+    RecordingMotor motor;
+    MotorCommand buffer[QUEUE_SIZE];
+    MotorCommandQueue queue(&motor, buffer, QUEUE_SIZE);
+
+    halBenchmark.clock = 1000000;
+    queue.runAt(Clockwise, 1000, 1500);
+    queue.brakeAt(1200);
+    queue.stop(10);
+
+    check(updateAt(&queue, 1499) && motor.count == 0, "Absolute commands", "command executed before its time");
+    check(!updateAt(&queue, 1510) && motor.count == 3 && motor.action == 's', "Absolute commands", "due commands not executed at once");
+}
+
+// Queues a relative command after clearing a queue, and after the queue ran idle: its delay is counted from now
+static void testIdleQueue()
+{
+    RecordingMotor motor;
+    MotorCommand buffer[QUEUE_SIZE];
+    MotorCommandQueue queue(&motor, buffer, QUEUE_SIZE);
+
+    halBenchmark.clock = 0;
+    queue.run(Clockwise, 1000, 1000);
+    updateAt(&queue, 10);
+    queue.clear();
+    check(queue.available() == 0, "Idle queue", "commands kept by clear()");
+    queue.stop(100);
+    check(updateAt(&queue, 109) && motor.count == 0, "Idle queue", "command executed before its time after clear()");
+    check(!updateAt(&queue, 110) && motor.count == 1 && motor.action == 's', "Idle queue", "command delayed by a cleared command");
+
+    updateAt(&queue, 1000);
+    queue.brake(50);
+    check(updateAt(&queue, 1049) && motor.count == 1, "Idle queue", "command executed before its time");
+    check(!updateAt(&queue, 1050) && motor.count == 2 && motor.action == 'b', "Idle queue", "command not chained from now");
+}
+
+/**
+ * Command of a random sequence
+ * @typedef {struct} SequenceCommand
+ * @property {unsigned long} time - Expected execution time, in timebase ticks
+ * @property {char} action - Motor operation
+ */
+struct SequenceCommand
+{
+    unsigned long time;
+    char action;
+};
+
+// Runs random sequences of relative and absolute commands, queued as the queue has room for them
+// and updated at random intervals, against the execution times expected from the queueing times.
+// The microseconds sequences are run across the clock overflow
+static void testRandomSequences(SpinTimebase timebase)
+{
+    unsigned long tick = 1000 / timebase;
+    RecordingMotor motor;
+    MotorCommand buffer[QUEUE_SIZE];
+    MotorCommandQueue queue(&motor, buffer, QUEUE_SIZE, timebase);
+    SequenceCommand commands[MAX_COMMANDS];
+    for (int sequence = 0; sequence < SEQUENCES; sequence++)
+    {
+        int size = 1 + nextRandom(MAX_COMMANDS);
+        int queued = 0, executed = 0;
+        unsigned long lastTime = 0;
+        motor.count = 0;
+        halBenchmark.clock = timebase == Microseconds ? 0UL - nextRandom(100000) : nextRandom(1000000) * 1000;
+        while (executed < size)
+        {
+            unsigned long now = halBenchmark.clock / tick;
+            for (; queued < size && queue.space() > 0; queued++)
+            {
+                // Relative commands are chained from now on an idle queue, and absolute ones may be in the past
+                SequenceCommand *command = &commands[queued];
+                command->action = "rsb"[nextRandom(3)];
+                unsigned long delay = nextRandom(200);
+                bool relative = nextRandom(2);
+                unsigned long time = relative ? (queue.available() == 0 ? now : lastTime) + delay : now + delay - 50;
+                bool accepted;
+                if (command->action == 'r')
+                    accepted = relative ? queue.run(Clockwise, 1 + nextRandom(65535), delay) : queue.runAt(Clockwise, 1 + nextRandom(65535), time);
+                else if (command->action == 's')
+                    accepted = relative ? queue.stop(delay) : queue.stopAt(time);
+                else
+                    accepted = relative ? queue.brake(delay) : queue.brakeAt(time);
+                check(accepted, "Random sequences", "command not queued");
+
+                // A command is never executed before the previous one
+                lastTime = time;
+                command->time = queued > 0 && (long)(time - commands[queued - 1].time) < 0 ? commands[queued - 1].time : time;
+            }
+
+            halBenchmark.clock += (1 + nextRandom(nextRandom(2) ? 2 : 60)) * tick;
+            now = halBenchmark.clock / tick;
+            queue.update();
+
+            // Every due command must be executed in order, and no other one
+            int due = executed;
+            while (due < queued && (long)(now - commands[due].time) >= 0)
+                due++;
+            if (motor.count != due || (due > executed && motor.action != commands[due - 1].action))
+            {
+                if (failures++ < 10)
+                    printf("Random sequences, timebase %d, sequence %d at %lu: expected %d commands executed, got %d\n",
+                           timebase, sequence, now, due, motor.count);
+                break;
+            }
+            executed = due;
+        }
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    testRelativeSequence();
+    testAbsoluteCommands();
+    testIdleQueue();
+    testRandomSequences(Milliseconds);
+    testRandomSequences(Microseconds);
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
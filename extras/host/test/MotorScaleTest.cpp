@@ -0,0 +1,109 @@
+// MotorScaleTest.cpp
+// Motor speed scaling test: checks the duty cycle set for every speed against the floating point scaling
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define DOUT1 2  // Driver IN1 input
+#define DOUT2 3  // Driver IN2 input
+#define PWMOUT 4 // Driver PWM input
+
+/**
+ * PWM backend with a given resolution, recording the written duty cycle
+ * @class
+ */
+class RecordingPWM : public PWMBackend
+{
+public:
+    uint16_t max;
+    uint16_t duty;
+
+    uint16_t resolution() override
+    {
+        return max;
+    }
+
+    void write(pin_size_t, uint16_t duty) override
+    {
+        this->duty = duty;
+    }
+};
+
+static int failures;
+
+/**
+ * Returns the duty cycle a speed was scaled to by the floating point Motor implementation
+ * @param {uint16_t} speed - Speed, from 1 to 65535
+ * @param {uint16_t} max - Duty cycle resolution
+ * @returns {uint16_t} Duty cycle
+ */
+static uint16_t referenceDuty(uint16_t speed, uint16_t max)
+{
+    return round(speed * (max / 65535.0));
+}
+
+// Checks the duty cycle set for a speed, reporting the first mismatches only
+static void check(const char *name, uint16_t max, uint16_t speed, uint16_t duty)
+{
+    uint16_t expected = referenceDuty(speed, max);
+    if (duty == expected)
+        return;
+
+    if (failures++ < 10)
+        printf("%s, resolution %u, speed %u: expected duty %u, got %u\n", name, max, speed, expected, duty);
+}
+
+// Checks a Motor driven by a PWM backend of a given resolution, for every speed
+static void testBackend(PinMap *pinMap, uint16_t max)
+{
+    RecordingPWM pwm;
+    pwm.max = max;
+    Motor motor(pinMap, &pwm);
+    for (uint32_t speed = 1; speed <= 65535; speed++)
+    {
+        motor.run(Clockwise, speed);
+        check("Motor", max, speed, pwm.duty);
+    }
+}
+
+int main()
+{
+    halBenchmark.fakePins = true;
+
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+
+    // analogWrite resolution. The motor is invalidated so every duty cycle is written
+    Motor motor(&pinMap);
+    for (uint32_t speed = 1; speed <= 65535; speed++)
+    {
+        motor.invalidate();
+        motor.run(Clockwise, speed);
+        check("Motor", 255, speed, halBenchmark.pins[PWMOUT]);
+    }
+
+    // TurboPWM resolution on SAMD21 processors
+    testBackend(&pinMap, 1000);
+
+    // SAMD21 timer periods (PER register) at 100kHz, 40kHz, 20kHz and 732Hz, and AVR 16-bit timer top values
+    // at 20kHz on 16MHz processors, at the lowest frequencies and at powers of two. Unlike the others,
+    // powers of two are coprime with 65535, so the scaled speeds reach every remainder of the division
+    const uint16_t periods[] = {240, 600, 1200, 32787, 400, 65535, 1024, 32768};
+    for (uint8_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++)
+        testBackend(&pinMap, periods[i]);
+
+    // Pin mapping set at compile time, always with analogWrite resolution
+    StaticMotor<DOUT1, DOUT2, PWMOUT> staticMotor;
+    for (uint32_t speed = 1; speed <= 65535; speed++)
+    {
+        staticMotor.run(Clockwise, speed);
+        check("StaticMotor", 255, speed, halBenchmark.pins[PWMOUT]);
+    }
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
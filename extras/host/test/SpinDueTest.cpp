@@ -0,0 +1,181 @@
+// SpinDueTest.cpp
+// Spin due time test: checks that a spinner updated only when nextUpdateDue() says so raises the same events
+// than a spinner updated on every tick
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define MAPS 500          // Random maps spun on every timebase
+#define MAX_MAP_POINTS 8  // Max points of a random map
+#define MAX_SEGMENT 1000  // Max duration of a random map segment, in milliseconds
+#define MAX_EVENTS 80000  // Max events raised by a random map
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from their events
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+/**
+ * Events raised by a spinner, in order
+ * @typedef {struct} EventLog
+ * @property {unsigned long} count - Number of events raised
+ * @property {SpinPoint[]} points - Spin point of every event
+ * @property {bool[]} finished - True for every spin finished event, false for every spin updated event
+ */
+struct EventLog
+{
+    unsigned long count;
+    SpinPoint points[MAX_EVENTS];
+    bool finished[MAX_EVENTS];
+};
+
+static EventLog tickLog, dueLog;
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+static void logEvent(EventLog *log, const SpinPoint *spinPoint, bool finished)
+{
+    if (log->count < MAX_EVENTS)
+    {
+        log->points[log->count] = *spinPoint;
+        log->finished[log->count] = finished;
+    }
+    log->count++;
+}
+
+static void spinUpdated(void *context, const SpinPoint *spinPoint)
+{
+    logEvent((EventLog *)context, spinPoint, false);
+}
+
+static void spinFinished(void *context, const SpinPoint *spinPoint)
+{
+    logEvent((EventLog *)context, spinPoint, true);
+}
+
+// Checks that both spinners raised the same events
+static void compareLogs(SpinTimebase timebase, int map)
+{
+    if (tickLog.count > MAX_EVENTS)
+    {
+        printf("Timebase %d, map %d: %lu events logged, the max is %d\n", timebase, map, tickLog.count, MAX_EVENTS);
+        failures++;
+        return;
+    }
+
+    for (unsigned long i = 0; i < tickLog.count || i < dueLog.count; i++)
+    {
+        if (i < tickLog.count && i < dueLog.count && tickLog.finished[i] == dueLog.finished[i] &&
+            tickLog.points[i].speed == dueLog.points[i].speed && tickLog.points[i].time == dueLog.points[i].time)
+            continue;
+
+        if (failures++ < 10)
+        {
+            printf("Timebase %d, map %d, event %lu: expected ", timebase, map, i);
+            if (i < tickLog.count)
+                printf("%s %u at %u ms, got ", tickLog.finished[i] ? "finished" : "updated", tickLog.points[i].speed, tickLog.points[i].time);
+            else
+                printf("no event, got ");
+            if (i < dueLog.count)
+                printf("%s %u at %u ms\n", dueLog.finished[i] ? "finished" : "updated", dueLog.points[i].speed, dueLog.points[i].time);
+            else
+                printf("no event\n");
+        }
+        return;
+    }
+}
+
+// Spins random maps on a timebase with two spinners: one on every tick, and the other one only
+// at the due times it returns. The microseconds maps are started right before the clock overflows
+static void spinRandomMaps(SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner tickSpinner(&motor, spinUpdated, spinFinished, &tickLog);
+    Spinner dueSpinner(&motor, spinUpdated, spinFinished, &dueLog);
+    tickSpinner.timebase(timebase);
+    dueSpinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so that the maps last a similar number of ticks
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    uint8_t segmentCurves[MAX_MAP_POINTS - 1];
+    unsigned long tickCalls = 0, dueCalls = 0;
+    for (int map = 0; map < MAPS; map++)
+    {
+        // Flat segments and short speed increments, so that the speed doesn't change on every tick
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        spinMap[0].time = 0;
+        spinMap[0].speed = nextRandom(65536);
+        for (uint8_t i = 1; i < mapSize; i++)
+        {
+            spinMap[i].time = spinMap[i - 1].time + 1 + nextRandom(maxSegment);
+            switch (nextRandom(4))
+            {
+            case 0:
+                spinMap[i].speed = spinMap[i - 1].speed;
+                break;
+            case 1:
+                spinMap[i].speed = spinMap[i - 1].speed + nextRandom(64) - 32;
+                break;
+            default:
+                spinMap[i].speed = nextRandom(65536);
+            }
+            segmentCurves[i - 1] = nextRandom(Exponential + 1);
+        }
+
+        bool curved = nextRandom(2);
+        tickLog.count = dueLog.count = 0;
+        halBenchmark.clock = timebase == Microseconds ? 0UL - 1 - nextRandom(spinMap[mapSize - 1].time * 1000UL) : nextRandom(1000000);
+        const SpinPoint *tickPoint = curved ? tickSpinner.start(Clockwise, spinMap, mapSize, segmentCurves)
+                                            : tickSpinner.start(Clockwise, spinMap, mapSize);
+        const SpinPoint *duePoint = curved ? dueSpinner.start(Clockwise, spinMap, mapSize, segmentCurves)
+                                           : dueSpinner.start(Clockwise, spinMap, mapSize);
+        unsigned long dueTime;
+        unsigned long ticks = (spinMap[mapSize - 1].time + 2UL) * timebase;
+        for (unsigned long tick = 0; tick < ticks && (tickPoint != NULL || duePoint != NULL); tick++)
+        {
+            halBenchmark.clock += 1000 / timebase;
+            unsigned long time = timebase == Microseconds ? halBenchmark.clock : halBenchmark.clock / 1000;
+            tickPoint = tickSpinner.spin();
+            tickCalls++;
+            if (duePoint != NULL && (!dueSpinner.nextUpdateDue(&dueTime) || (long)(time - dueTime) >= 0))
+            {
+                duePoint = dueSpinner.spin();
+                dueCalls++;
+            }
+        }
+        compareLogs(timebase, map);
+    }
+
+    printf("Timebase %d: %lu spin() calls on every tick, %lu when due\n", timebase, tickCalls, dueCalls);
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(Milliseconds);
+    spinRandomMaps(Microseconds);
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// SpinEventFilterTest.cpp
+// Spin event filter test: checks the spin updated events decimated by Spinner::updateFilter()
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define MAPS 2000         // Random maps spun
+#define MAX_MAP_POINTS 8  // Max points of a random map
+#define MAX_SEGMENT 2000  // Max duration of a random map segment, in milliseconds
+#define MAX_EVENTS 20000  // Max events raised by a random map
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from their events
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+/**
+ * Events raised by a spinner, in order
+ * @typedef {struct} EventLog
+ * @property {unsigned long} count - Number of events raised
+ * @property {SpinPoint[]} points - Spin point of every event
+ * @property {bool[]} finished - True for every spin finished event, false for every spin updated event
+ */
+struct EventLog
+{
+    unsigned long count;
+    SpinPoint points[MAX_EVENTS];
+    bool finished[MAX_EVENTS];
+};
+
+static EventLog spinnerLog, filteredLog, expectedLog;
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+static void logEvent(EventLog *log, const SpinPoint *spinPoint, bool finished)
+{
+    if (log->count < MAX_EVENTS)
+    {
+        log->points[log->count] = *spinPoint;
+        log->finished[log->count] = finished;
+    }
+    log->count++;
+}
+
+static void spinUpdated(void *context, const SpinPoint *spinPoint)
+{
+    logEvent((EventLog *)context, spinPoint, false);
+}
+
+static void spinFinished(void *context, const SpinPoint *spinPoint)
+{
+    logEvent((EventLog *)context, spinPoint, true);
+}
+
+// Decimates the events of an unfiltered spinner: an updated event is kept if both the time and the speed
+// changed enough since the last kept one. Signed speeds are compared as offset speeds
+static void filterLog(const EventLog *log, EventLog *filtered, uint16_t minInterval, uint16_t minSpeedDelta, uint16_t speedMask)
+{
+    filtered->count = 0;
+    const SpinPoint *raised = NULL;
+    for (unsigned long i = 0; i < log->count; i++)
+    {
+        const SpinPoint *spinPoint = &log->points[i];
+        if (!log->finished[i] && raised != NULL)
+        {
+            uint16_t speed = spinPoint->speed ^ speedMask;
+            uint16_t raisedSpeed = raised->speed ^ speedMask;
+            if ((uint16_t)(spinPoint->time - raised->time) < minInterval ||
+                (speed > raisedSpeed ? speed - raisedSpeed : raisedSpeed - speed) < minSpeedDelta)
+                continue;
+        }
+        if (!log->finished[i])
+            raised = spinPoint;
+        logEvent(filtered, spinPoint, log->finished[i]);
+    }
+}
+
+// Checks that the filtered spinner raised the expected events
+static void compareLogs(int map)
+{
+    for (unsigned long i = 0; i < expectedLog.count || i < filteredLog.count; i++)
+    {
+        if (i < expectedLog.count && i < filteredLog.count && expectedLog.finished[i] == filteredLog.finished[i] &&
+            expectedLog.points[i].speed == filteredLog.points[i].speed && expectedLog.points[i].time == filteredLog.points[i].time)
+            continue;
+
+        if (failures++ < 10)
+        {
+            printf("Map %d, event %lu: expected ", map, i);
+            if (i < expectedLog.count)
+                printf("%s %u at %u ms, got ", expectedLog.finished[i] ? "finished" : "updated", expectedLog.points[i].speed, expectedLog.points[i].time);
+            else
+                printf("no event, got ");
+            if (i < filteredLog.count)
+                printf("%s %u at %u ms\n", filteredLog.finished[i] ? "finished" : "updated", filteredLog.points[i].speed, filteredLog.points[i].time);
+            else
+                printf("no event\n");
+        }
+        return;
+    }
+}
+
+// Spins random maps, half of them signed, with an unfiltered spinner and a spinner with random filter thresholds,
+// at the same random times. Both spinners share their callback functions, and log their events to their context
+static void spinRandomMaps()
+{
+    NullMotor motor;
+    Spinner spinner(&motor, spinUpdated, spinFinished, &spinnerLog);
+    Spinner filteredSpinner(&motor, spinUpdated, spinFinished, &filteredLog);
+
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    SignedSpinPoint signedSpinMap[MAX_MAP_POINTS];
+    for (int map = 0; map < MAPS; map++)
+    {
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        for (uint8_t i = 0; i < mapSize; i++)
+        {
+            spinMap[i].time = i == 0 ? 0 : spinMap[i - 1].time + 1 + nextRandom(MAX_SEGMENT);
+            spinMap[i].speed = 1 + nextRandom(65535);
+            signedSpinMap[i].time = spinMap[i].time;
+            signedSpinMap[i].velocity = (int16_t)(spinMap[i].speed ^ 0x8000);
+        }
+
+        // Either threshold may be zero, and the interval may exceed the spin point time range
+        uint16_t minInterval = nextRandom(3) == 0 ? 0 : nextRandom(nextRandom(2) ? 100 : 65536);
+        uint16_t minSpeedDelta = nextRandom(3) == 0 ? 0 : nextRandom(nextRandom(2) ? 100 : 65536);
+        filteredSpinner.updateFilter(minInterval, minSpeedDelta);
+
+        bool isSigned = nextRandom(2);
+        spinnerLog.count = filteredLog.count = 0;
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *spinPoint = isSigned ? spinner.start(Clockwise, signedSpinMap, mapSize) : spinner.start(Clockwise, spinMap, mapSize);
+        if (isSigned)
+            filteredSpinner.start(Clockwise, signedSpinMap, mapSize);
+        else
+            filteredSpinner.start(Clockwise, spinMap, mapSize);
+        while (spinPoint != NULL)
+        {
+            // Mostly consecutive milliseconds, else up to a whole segment
+            halBenchmark.clock += (nextRandom(16) ? 1 : 1 + nextRandom(MAX_SEGMENT)) * 1000;
+            spinPoint = spinner.spin();
+            filteredSpinner.spin();
+        }
+
+        if (spinnerLog.count > MAX_EVENTS)
+        {
+            printf("Map %d: %lu events logged, the max is %d\n", map, spinnerLog.count, MAX_EVENTS);
+            failures++;
+            continue;
+        }
+        filterLog(&spinnerLog, &expectedLog, minInterval, minSpeedDelta, isSigned ? 0x8000 : 0);
+        compareLogs(map);
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps();
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
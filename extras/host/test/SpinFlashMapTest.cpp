@@ -0,0 +1,144 @@
+// SpinFlashMapTest.cpp
+// Flash spin map test: checks that flash and packed maps are spun like the same maps stored in RAM
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The host stand-in of PROGMEM is plain memory, so the flash and packed maps are built at run time
+#include <tb6612fng.h>
+
+#define MAPS 2000         // Random maps spun on every timebase
+#define MAX_MAP_POINTS 12 // Max points of a random map
+#define MAX_SEGMENT 2000  // Max duration of a random map segment, in milliseconds
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from the spin() calls
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Packs a spin map with the SPIN_PACKED_* encoding, returning the packed map length
+static uint8_t packSpinMap(const SpinPoint spinMap[], uint8_t mapSize, uint8_t packedSpinMap[])
+{
+    uint8_t length = 0;
+    uint8_t start[] = {SPIN_PACKED_START(spinMap[0].speed)};
+    for (uint8_t i = 0; i < sizeof(start); i++)
+        packedSpinMap[length++] = start[i];
+
+    for (uint8_t i = 1; i < mapSize; i++)
+    {
+        uint16_t timeIncrement = spinMap[i].time - spinMap[i - 1].time;
+        int32_t speedIncrement = (int32_t)spinMap[i].speed - spinMap[i - 1].speed;
+        if (timeIncrement < 256 && speedIncrement >= -128 && speedIncrement <= 127)
+        {
+            uint8_t delta[] = {SPIN_PACKED_DELTA(timeIncrement, speedIncrement)};
+            for (uint8_t j = 0; j < sizeof(delta); j++)
+                packedSpinMap[length++] = delta[j];
+        }
+        else
+        {
+            uint8_t point[] = {SPIN_PACKED_POINT(timeIncrement, spinMap[i].speed)};
+            for (uint8_t j = 0; j < sizeof(point); j++)
+                packedSpinMap[length++] = point[j];
+        }
+    }
+
+    return length;
+}
+
+// Checks that a spinner reached the same point than the RAM map spinner
+static void check(const char *storage, int map, unsigned long elapsedTime, const SpinPoint *expected, const SpinPoint *spinPoint)
+{
+    if ((expected == NULL) == (spinPoint == NULL) && (expected == NULL || expected->speed == spinPoint->speed))
+        return;
+
+    if (failures++ < 10)
+        printf("Map %d, %s map at %lu ticks: expected speed %d, got %d\n", map, storage, elapsedTime,
+               expected != NULL ? (int)expected->speed : -1, spinPoint != NULL ? (int)spinPoint->speed : -1);
+}
+
+// Spins random maps from RAM, from flash and packed on a timebase, at the same random times
+static void spinRandomMaps(SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner ramSpinner(&motor), flashSpinner(&motor), packedSpinner(&motor);
+    ramSpinner.timebase(timebase);
+    flashSpinner.timebase(timebase);
+    packedSpinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so the spin calls reach the segment ends
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    uint8_t segmentCurves[MAX_MAP_POINTS - 1];
+    uint8_t packedSpinMap[2 + 5 * (MAX_MAP_POINTS - 1)];
+    for (int map = 0; map < MAPS; map++)
+    {
+        // Short segments and speed increments as often as long ones, so both packed encodings are used
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        spinMap[0].time = 0;
+        spinMap[0].speed = nextRandom(65536);
+        for (uint8_t i = 1; i < mapSize; i++)
+        {
+            bool delta = nextRandom(2);
+            spinMap[i].time = spinMap[i - 1].time + 1 + nextRandom(delta ? 255 : maxSegment);
+            spinMap[i].speed = delta ? spinMap[i - 1].speed + nextRandom(256) - 128 : nextRandom(65536);
+            segmentCurves[i - 1] = nextRandom(Exponential + 1);
+        }
+        packSpinMap(spinMap, mapSize, packedSpinMap);
+
+        // Curved maps are not packed: they're spun from RAM and from flash only
+        bool curved = nextRandom(2);
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *ramPoint = curved ? ramSpinner.start(Clockwise, spinMap, mapSize, segmentCurves)
+                                           : ramSpinner.start(Clockwise, spinMap, mapSize);
+        const SpinPoint *flashPoint = curved ? flashSpinner.startFlash(Clockwise, spinMap, mapSize, segmentCurves)
+                                             : flashSpinner.startFlash(Clockwise, spinMap, mapSize);
+        const SpinPoint *packedPoint = curved ? ramPoint : packedSpinner.startPacked(Clockwise, packedSpinMap, mapSize);
+        unsigned long elapsedTime = 0;
+        while (true)
+        {
+            check("flash", map, elapsedTime, ramPoint, flashPoint);
+            check("packed", map, elapsedTime, ramPoint, packedPoint);
+            if (ramPoint == NULL)
+                break;
+
+            // Mostly consecutive ticks, else up to a whole segment
+            unsigned long interval = nextRandom(4) ? 1 : 1 + nextRandom(maxSegment * timebase);
+            elapsedTime += interval;
+            halBenchmark.clock += interval * (1000 / timebase);
+            ramPoint = ramSpinner.spin();
+            flashPoint = flashSpinner.spin();
+            packedPoint = curved ? ramPoint : packedSpinner.spin();
+        }
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(Milliseconds);
+    spinRandomMaps(Microseconds);
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
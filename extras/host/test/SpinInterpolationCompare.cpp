@@ -0,0 +1,150 @@
+// SpinInterpolationCompare.cpp
+// Compares the speeds written by the fixed point and floating point builds of SpinInterpolationTest
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_MAP_POINTS 8
+
+// Linear segment curve, as defined by the SpinCurve enum
+#define LINEAR 0
+
+/**
+ * Map point, as written by SpinInterpolationTest
+ * @typedef {struct} MapPoint
+ */
+struct MapPoint
+{
+    unsigned long time;
+    unsigned long speed;
+    unsigned curve;
+};
+
+/**
+ * Gets the exact speed of a linear segment at a given elapsed time, if it's halfway between two integers
+ * @param {MapPoint[]} map - Map points, with times in timebase ticks
+ * @param {int} mapSize - Number of map points
+ * @param {unsigned long} elapsedTime - Elapsed time since the spin start, in timebase ticks
+ * @param {unsigned long*} speed - Exact speed, its absolute increment since the segment start rounded half up
+ * @returns {bool} True if the speed is halfway between two integers
+ * @note The floating point build rounds ties either way, since the time fraction of the segment isn't exact in binary
+ */
+static bool getLinearTie(const MapPoint map[], int mapSize, unsigned long elapsedTime, unsigned long *speed)
+{
+    for (int i = 0; i < mapSize - 1; i++)
+    {
+        if (elapsedTime < map[i].time || elapsedTime > map[i + 1].time)
+            continue;
+
+        unsigned long long x = elapsedTime - map[i].time;
+        unsigned long long dx = map[i + 1].time - map[i].time;
+        bool descending = map[i + 1].speed < map[i].speed;
+        unsigned long long dy = descending ? map[i].speed - map[i + 1].speed : map[i + 1].speed - map[i].speed;
+        if (map[i].curve != LINEAR || 2 * x * dy % (2 * dx) != dx)
+            return false;
+
+        unsigned long increment = (2 * x * dy + dx) / (2 * dx);
+        *speed = descending ? map[i].speed - increment : map[i].speed + increment;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <fixed point output> <floating point output>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fixedOutput = fopen(argv[1], "r");
+    FILE *floatOutput = fopen(argv[2], "r");
+    if (fixedOutput == NULL || floatOutput == NULL)
+    {
+        perror("fopen");
+        return 1;
+    }
+
+    // Both builds spin the same maps and call spin() at the same times,
+    // so their lines only differ in the speeds
+    char fixedLine[64], floatLine[64];
+    MapPoint map[MAX_MAP_POINTS];
+    int mapSize = 0;
+    unsigned long lines = 0, speeds = 0, ties = 0, mismatches = 0;
+    while (fgets(fixedLine, sizeof(fixedLine), fixedOutput) != NULL)
+    {
+        lines++;
+        if (fgets(floatLine, sizeof(floatLine), floatOutput) == NULL)
+        {
+            fprintf(stderr, "Floating point output is shorter, line %lu\n", lines);
+            return 1;
+        }
+
+        // Map header and points
+        unsigned timebase;
+        if (sscanf(fixedLine, "map %u %d", &timebase, &mapSize) == 2)
+        {
+            if (strcmp(fixedLine, floatLine) != 0 || mapSize < 2 || mapSize > MAX_MAP_POINTS)
+            {
+                fprintf(stderr, "Maps differ, line %lu\n", lines);
+                return 1;
+            }
+
+            for (int i = 0; i < mapSize; i++)
+            {
+                lines++;
+                if (fgets(fixedLine, sizeof(fixedLine), fixedOutput) == NULL ||
+                    fgets(floatLine, sizeof(floatLine), floatOutput) == NULL ||
+                    strcmp(fixedLine, floatLine) != 0 ||
+                    sscanf(fixedLine, "%lu %lu %u", &map[i].time, &map[i].speed, &map[i].curve) != 3)
+                {
+                    fprintf(stderr, "Maps differ, line %lu\n", lines);
+                    return 1;
+                }
+                map[i].time *= timebase;
+            }
+            continue;
+        }
+
+        // Spin speeds: equal or, on the exact halves of linear segments, one apart and exact in fixed point
+        if (strcmp(fixedLine, floatLine) == 0)
+        {
+            if (strcmp(fixedLine, "end\n") != 0)
+                speeds++;
+            continue;
+        }
+
+        unsigned long fixedTime, fixedSpeed, floatTime, floatSpeed;
+        if (sscanf(fixedLine, "%lu %lu", &fixedTime, &fixedSpeed) != 2 ||
+            sscanf(floatLine, "%lu %lu", &floatTime, &floatSpeed) != 2 ||
+            fixedTime != floatTime)
+        {
+            fprintf(stderr, "Spin calls differ, line %lu\n", lines);
+            return 1;
+        }
+
+        speeds++;
+        unsigned long tieSpeed;
+        if ((fixedSpeed == floatSpeed + 1 || floatSpeed == fixedSpeed + 1) &&
+            getLinearTie(map, mapSize, fixedTime, &tieSpeed) && fixedSpeed == tieSpeed)
+        {
+            ties++;
+            continue;
+        }
+
+        fprintf(stderr, "Line %lu: fixed point speed %lu, floating point speed %lu\n", lines, fixedSpeed, floatSpeed);
+        mismatches++;
+    }
+
+    if (fgets(floatLine, sizeof(floatLine), floatOutput) != NULL)
+    {
+        fprintf(stderr, "Fixed point output is shorter\n");
+        return 1;
+    }
+
+    printf("%lu speeds compared, %lu rounded differently on exact halves, %lu mismatches\n", speeds, ties, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// SpinInterpolationTest.cpp
+// Spinner speed interpolation test: writes the speeds reached by random spins, for comparing them between builds
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Built once with fixed point interpolation and once with TB6612FNG_FLOAT_INTERPOLATION defined.
+// The speeds written by both builds are compared by SpinInterpolationCompare
+#include <tb6612fng.h>
+
+#define MAPS 2000         // Random maps spun on every timebase
+#define MAX_MAP_POINTS 8  // Max points of a random map
+#define MAX_SEGMENT 3000  // Max duration of a random map segment, in milliseconds
+
+/**
+ * Motor ignoring the speeds set by the spinner, that are read from the spin() calls
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+// Xorshift pseudo-random generator, so every build spins the same maps
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Random speed, biased towards the range limits and short speed increments
+static uint16_t randomSpeed(uint16_t previous)
+{
+    switch (nextRandom(4))
+    {
+    case 0:
+        return nextRandom(2) ? 65535 : 0;
+    case 1:
+        return previous + nextRandom(64) - 32;
+    default:
+        return nextRandom(65536);
+    }
+}
+
+// Random interval between spin() calls: mostly consecutive ticks, else a few ticks or up to a whole segment
+static unsigned long randomInterval(unsigned long maxSegmentTicks)
+{
+    uint32_t draw = nextRandom(20);
+    if (draw < 14)
+        return 1;
+    if (draw < 19)
+        return 1 + nextRandom(16);
+    return 1 + nextRandom(maxSegmentTicks);
+}
+
+// Spins random maps on a timebase, writing the speed returned by every spin() call
+static void spinRandomMaps(FILE *output, SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner spinner(&motor);
+    spinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so the spin calls reach the segment ends
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    uint8_t segmentCurves[MAX_MAP_POINTS - 1];
+    for (int map = 0; map < MAPS; map++)
+    {
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        spinMap[0].time = 0;
+        spinMap[0].speed = randomSpeed(nextRandom(65536));
+        for (uint8_t i = 1; i < mapSize; i++)
+        {
+            unsigned long duration = 1 + nextRandom(maxSegment);
+            spinMap[i].time = spinMap[i - 1].time + duration;
+            spinMap[i].speed = randomSpeed(spinMap[i - 1].speed);
+            segmentCurves[i - 1] = nextRandom(4) == 0 ? (uint8_t)nextRandom(Exponential + 1) : (uint8_t)Linear;
+        }
+
+        // Half of the maps are linear
+        bool curved = nextRandom(2);
+        fprintf(output, "map %d %d\n", timebase, mapSize);
+        for (uint8_t i = 0; i < mapSize; i++)
+            fprintf(output, "%u %u %u\n", spinMap[i].time, spinMap[i].speed, curved && i < mapSize - 1 ? (unsigned)segmentCurves[i] : (unsigned)Linear);
+
+        // The fake clock counts microseconds
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *spinPoint = curved ? spinner.start(Clockwise, spinMap, mapSize, segmentCurves)
+                                            : spinner.start(Clockwise, spinMap, mapSize);
+        unsigned long elapsedTime = 0;
+        while (spinPoint != NULL)
+        {
+            fprintf(output, "%lu %u\n", elapsedTime, spinPoint->speed);
+            unsigned long interval = randomInterval(maxSegment * timebase);
+            elapsedTime += interval;
+            halBenchmark.clock += interval * (1000 / timebase);
+            spinPoint = spinner.spin();
+        }
+        fprintf(output, "end\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <output file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[1], "w");
+    if (output == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(output, Milliseconds);
+    spinRandomMaps(output, Microseconds);
+
+    fclose(output);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// SpinProfileTest.cpp
+// Spin profile test: checks that looping profiles are spun like the same profiles unrolled
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define PROFILES 2000         // Random profiles spun on every timebase
+#define MAX_PROFILE_POINTS 6  // Max points of a random profile
+#define MAX_LOOPS 8           // Max loop count of a random profile
+#define MAX_SEGMENT 3000      // Max duration of a random profile segment, in milliseconds
+#define MAX_UNROLLED_POINTS (MAX_PROFILE_POINTS + MAX_LOOPS * (MAX_PROFILE_POINTS - 1))
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from the spin() calls
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Checks a condition, printing the first failures
+static void check(bool condition, const char *message)
+{
+    if (condition || failures++ >= 10)
+        return;
+
+    printf("%s\n", message);
+}
+
+// Spins random looping profiles and the same profiles unrolled on a timebase, at the same random times,
+// some of them long enough to skip several loop cycles. Profiles looping forever are checked up to the
+// end of their unrolled profile
+static void spinRandomProfiles(SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner loopSpinner(&motor), unrolledSpinner(&motor);
+    loopSpinner.timebase(timebase);
+    unrolledSpinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so the spin calls reach the segment ends
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    LongSpinPoint points[MAX_PROFILE_POINTS], unrolledPoints[MAX_UNROLLED_POINTS];
+    uint8_t curves[MAX_PROFILE_POINTS - 1], unrolledCurves[MAX_UNROLLED_POINTS - 1];
+    for (int profile = 0; profile < PROFILES; profile++)
+    {
+        // The loop point speed is the last point speed, so the unrolled profile doesn't step
+        uint8_t size = 2 + nextRandom(MAX_PROFILE_POINTS - 1);
+        uint8_t loopIndex = nextRandom(size - 1);
+        uint16_t loopCount = nextRandom(8) == 0 ? SPIN_LOOP_FOREVER : nextRandom(MAX_LOOPS + 1);
+        for (uint8_t i = 0; i < size; i++)
+        {
+            points[i].time = i == 0 ? 0 : points[i - 1].time + 1 + nextRandom(maxSegment);
+            points[i].speed = nextRandom(65536);
+            curves[i < size - 1 ? i : 0] = nextRandom(Exponential + 1);
+        }
+        points[size - 1].speed = points[loopIndex].speed;
+
+        uint8_t unrolledSize = size;
+        uint16_t unrolledLoops = loopCount == SPIN_LOOP_FOREVER ? MAX_LOOPS : loopCount;
+        unsigned long loopDuration = points[size - 1].time - points[loopIndex].time;
+        for (uint8_t i = 0; i < size; i++)
+        {
+            unrolledPoints[i] = points[i];
+            unrolledCurves[i < size - 1 ? i : 0] = curves[i < size - 1 ? i : 0];
+        }
+        for (uint16_t loop = 1; loop <= unrolledLoops; loop++)
+        {
+            for (uint8_t i = loopIndex; i < size - 1; i++)
+            {
+                unrolledPoints[unrolledSize].time = points[i + 1].time + loop * loopDuration;
+                unrolledPoints[unrolledSize].speed = points[i + 1].speed;
+                unrolledCurves[unrolledSize - 1] = curves[i];
+                unrolledSize++;
+            }
+        }
+
+        bool curved = nextRandom(2);
+        SpinProfile loopProfile = curved ? SpinProfile(points, size, curves) : SpinProfile(points, size);
+        SpinProfile unrolledProfile = curved ? SpinProfile(unrolledPoints, unrolledSize, unrolledCurves) : SpinProfile(unrolledPoints, unrolledSize);
+        check(loopProfile.loop(loopIndex, loopCount), "Loop not set");
+
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *loopPoint = loopSpinner.start(Clockwise, &loopProfile);
+        const SpinPoint *unrolledPoint = unrolledSpinner.start(Clockwise, &unrolledProfile);
+        unsigned long elapsedTime = 0;
+        unsigned long endTime = unrolledPoints[unrolledSize - 1].time * timebase;
+        while (loopCount != SPIN_LOOP_FOREVER || elapsedTime <= endTime)
+        {
+            if (((loopPoint == NULL) != (unrolledPoint == NULL) || (loopPoint != NULL && loopPoint->speed != unrolledPoint->speed)) &&
+                failures++ < 10)
+            {
+                printf("Timebase %d, profile %d at %lu ticks: expected speed %d, got %d\n", timebase, profile, elapsedTime,
+                       unrolledPoint != NULL ? (int)unrolledPoint->speed : -1, loopPoint != NULL ? (int)loopPoint->speed : -1);
+            }
+            if (loopPoint == NULL || unrolledPoint == NULL)
+                break;
+
+            // Mostly consecutive ticks, else up to three loop cycles
+            unsigned long interval = nextRandom(8) ? 1 : 1 + nextRandom((3 * loopDuration + 1) * timebase);
+            elapsedTime += interval;
+            halBenchmark.clock += interval * (1000 / timebase);
+            loopPoint = loopSpinner.spin();
+            unrolledPoint = unrolledSpinner.spin();
+        }
+        loopSpinner.abort();
+        unrolledSpinner.abort();
+    }
+}
+
+// Sets loops whose loop point is not before the last profile point, even if they don't loop
+static void testLoopPoint()
+{
+    LongSpinPoint points[3] = {{0, 0}, {1000, 100}, {0, 200}};
+    SpinProfile profile(points, 3);
+    check(profile.loop(1, 5), "Loop point before the last point rejected");
+    check(!profile.loop(2, 5), "Loop point at the last point accepted");
+    check(!profile.loop(2, 0), "Loop point at the last point accepted without looping");
+    check(!profile.loop(200, 0), "Loop point out of the profile accepted without looping");
+    check(profile.loop(0, 0), "Loop reset rejected");
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomProfiles(Milliseconds);
+    spinRandomProfiles(Microseconds);
+    testLoopPoint();
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
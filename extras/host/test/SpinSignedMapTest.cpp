@@ -0,0 +1,187 @@
+// SpinSignedMapTest.cpp
+// Signed spin map test: checks that signed maps are spun like offset maps, and the motor outputs they set
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define MAPS 2000         // Random maps spun on every timebase
+#define MAX_MAP_POINTS 8  // Max points of a random map
+#define MAX_SEGMENT 2000  // Max duration of a random map segment, in milliseconds
+
+/**
+ * Motor recording the last output set by the spinner
+ * @class
+ */
+class RecordingMotor : public MotorInterface
+{
+public:
+    enum Output
+    {
+        Running,
+        Stopped,
+        Braked
+    };
+
+    Output output = Stopped;
+    Direction direction = Clockwise;
+    uint16_t speed = 0;
+
+    void run(Direction runDirection, uint16_t runSpeed) override
+    {
+        output = Running;
+        direction = runDirection;
+        speed = runSpeed;
+    }
+
+    void stop() override
+    {
+        output = Stopped;
+    }
+
+    void brake() override
+    {
+        output = Braked;
+    }
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Random velocity, biased towards zero, the range limits and the opposite sign of the previous one
+static int16_t randomVelocity(int16_t previous)
+{
+    switch (nextRandom(4))
+    {
+    case 0:
+        return nextRandom(3) == 0 ? 0 : nextRandom(2) ? 32767 : -32767;
+    case 1:
+        return -previous + (int16_t)nextRandom(64) - 32;
+    default:
+        return (int16_t)nextRandom(65535) - 32767;
+    }
+}
+
+// Checks that the motor output matches a velocity: velocities from 1 to 32767 are scaled to speeds from 2 to 65535,
+// negative ones reverse the direction, and zero stops or brakes the motor
+static void checkOutput(const char *test, int map, unsigned long elapsedTime, const RecordingMotor *motor, int16_t velocity, ZeroSpeedMode mode)
+{
+    uint16_t magnitude = velocity < 0 ? -velocity : velocity;
+    uint16_t speed = (magnitude << 1) | (magnitude >> 14);
+    Direction direction = velocity < 0 ? CounterClockwise : Clockwise;
+    bool expected = velocity == 0 ? motor->output == (mode == Brake ? RecordingMotor::Braked : RecordingMotor::Stopped)
+                                  : motor->output == RecordingMotor::Running && motor->direction == direction && motor->speed == speed;
+    if (expected || failures++ >= 10)
+        return;
+
+    printf("%s, map %d at %lu ticks: velocity %d, got motor output %d, direction %d, speed %u\n", test, map, elapsedTime,
+           velocity, (int)motor->output, (int)motor->direction, motor->speed);
+}
+
+// Spins random signed maps and the same maps offset by 32768 on a timebase, at the same random times
+static void spinRandomMaps(SpinTimebase timebase)
+{
+    RecordingMotor signedMotor, offsetMotor;
+    Spinner signedSpinner(&signedMotor), offsetSpinner(&offsetMotor);
+    signedSpinner.timebase(timebase);
+    offsetSpinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so the spin calls reach the segment ends
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    SignedSpinPoint signedSpinMap[MAX_MAP_POINTS];
+    SpinPoint offsetSpinMap[MAX_MAP_POINTS];
+    uint8_t segmentCurves[MAX_MAP_POINTS];
+    for (int map = 0; map < MAPS; map++)
+    {
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        for (uint8_t i = 0; i < mapSize; i++)
+        {
+            signedSpinMap[i].time = i == 0 ? 0 : signedSpinMap[i - 1].time + 1 + nextRandom(maxSegment);
+            signedSpinMap[i].velocity = randomVelocity(i == 0 ? 0 : signedSpinMap[i - 1].velocity);
+            if (signedSpinMap[i].velocity == -32768)
+                signedSpinMap[i].velocity = -32767;
+            offsetSpinMap[i].time = signedSpinMap[i].time;
+            offsetSpinMap[i].speed = (uint16_t)signedSpinMap[i].velocity ^ 0x8000;
+            segmentCurves[i] = nextRandom(Exponential + 1);
+        }
+
+        bool curved = nextRandom(2);
+        ZeroSpeedMode mode = nextRandom(2) ? Brake : Coast;
+        signedSpinner.zeroSpeed(mode, 0);
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *signedPoint = curved ? signedSpinner.start(Clockwise, signedSpinMap, mapSize, segmentCurves)
+                                              : signedSpinner.start(Clockwise, signedSpinMap, mapSize);
+        const SpinPoint *offsetPoint = curved ? offsetSpinner.start(Clockwise, offsetSpinMap, mapSize, segmentCurves)
+                                              : offsetSpinner.start(Clockwise, offsetSpinMap, mapSize);
+        unsigned long elapsedTime = 0;
+        while (true)
+        {
+            // Spin points hold the signed velocity in two's complement
+            if ((signedPoint == NULL) != (offsetPoint == NULL) ||
+                (signedPoint != NULL && signedPoint->speed != (offsetPoint->speed ^ 0x8000)))
+            {
+                if (failures++ < 10)
+                    printf("Map %d at %lu ticks: expected velocity %d, got %d\n", map, elapsedTime,
+                           offsetPoint != NULL ? (int)offsetPoint->speed - 32768 : -1, signedPoint != NULL ? (int)(int16_t)signedPoint->speed : -1);
+            }
+            if (signedPoint == NULL || offsetPoint == NULL)
+                break;
+            checkOutput("Output", map, elapsedTime, &signedMotor, (int16_t)signedPoint->speed, mode);
+
+            // Mostly consecutive ticks, else up to a whole segment
+            unsigned long interval = nextRandom(4) ? 1 : 1 + nextRandom(maxSegment * timebase);
+            elapsedTime += interval;
+            halBenchmark.clock += interval * (1000 / timebase);
+            signedPoint = signedSpinner.spin();
+            offsetPoint = offsetSpinner.spin();
+        }
+    }
+}
+
+// Reverses a motor with a reversal dwell: the motor is kept braked after the zero crossing,
+// while the map velocities keep being reached
+static void testReversalDwell()
+{
+    RecordingMotor motor;
+    Spinner spinner(&motor);
+    spinner.zeroSpeed(Brake, 50);
+
+    // The velocity crosses zero at 500 milliseconds
+    SignedSpinPoint spinMap[2] = {{16384, 0}, {-16384, 1000}};
+    halBenchmark.clock = 0;
+    const SpinPoint *spinPoint = spinner.start(Clockwise, spinMap, 2);
+    for (unsigned long elapsedTime = 0; spinPoint != NULL; elapsedTime++)
+    {
+        int16_t velocity = (int16_t)spinPoint->speed;
+        int16_t expected = elapsedTime >= 1000 ? -16384 : 16384 - (int16_t)((elapsedTime * 32768 + 500) / 1000);
+        if (velocity != expected && failures++ < 10)
+            printf("Reversal dwell at %lu ms: expected velocity %d, got %d\n", elapsedTime, expected, velocity);
+        checkOutput("Reversal dwell", 0, elapsedTime, &motor, elapsedTime >= 500 && elapsedTime < 550 ? 0 : velocity, Brake);
+
+        halBenchmark.clock += 1000;
+        spinPoint = spinner.spin();
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(Milliseconds);
+    spinRandomMaps(Microseconds);
+    testReversalDwell();
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// SpinSlopeTest.cpp
+// Spin map segment slope test: checks the slopes calculated with 32-bit math against a 64-bit division
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The slopes are read from compiled spin maps, that store the slope of every segment
+#include <tb6612fng.h>
+
+#define MAPS 1000000 // Random segments checked on every timebase
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Checks the slope of a segment, compiled on a given timebase, against the rounded up 64-bit division
+static void check(uint16_t fromSpeed, uint16_t toSpeed, uint16_t duration, uint8_t curve, SpinTimebase timebase)
+{
+    SpinPoint spinMap[2] = {{fromSpeed, 0}, {toSpeed, duration}};
+    uint8_t segmentCurves[1] = {curve};
+    CompiledSpinSegment segments[2];
+    CompiledSpinMap compiledSpinMap(segments, 2);
+    if (!compiledSpinMap.compile(spinMap, 2, segmentCurves, timebase))
+    {
+        printf("Segment from %u to %u in %u ms not compiled\n", fromSpeed, toSpeed, duration);
+        failures++;
+        return;
+    }
+
+    uint64_t speedIncrement = curve != Linear ? 0xFFFF : toSpeed < fromSpeed ? fromSpeed - toSpeed : toSpeed - fromSpeed;
+    uint64_t timeIncrement = (uint64_t)duration * timebase;
+    uint64_t expected = ((speedIncrement << 48) + timeIncrement - 1) / timeIncrement;
+    uint64_t slope = 0;
+    for (int8_t limb = 3; limb >= 0; limb--)
+        slope = (slope << 16) | segments[0].slope[limb];
+    if (slope == expected || failures++ >= 10)
+        return;
+
+    printf("Segment from %u to %u in %u ticks: expected slope %llx, got %llx\n", fromSpeed, toSpeed,
+           (unsigned)timeIncrement, (unsigned long long)expected, (unsigned long long)slope);
+}
+
+// Checks the range limits and random segments on a timebase
+static void testTimebase(SpinTimebase timebase)
+{
+    const uint16_t speeds[] = {0, 1, 2, 0x7FFF, 0x8000, 0xFFFE, 0xFFFF};
+    const uint16_t durations[] = {1, 2, 3, 65, 66, 1000, 0x7FFF, 0xFFFE, 0xFFFF};
+    for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+    {
+        for (uint8_t j = 0; j < sizeof(durations) / sizeof(durations[0]); j++)
+        {
+            check(0, speeds[i], durations[j], Linear, timebase);
+            check(speeds[i], 0, durations[j], Linear, timebase);
+        }
+    }
+
+    for (uint32_t i = 0; i < MAPS; i++)
+    {
+        // Short segments as often as long ones
+        uint16_t duration = 1 + nextRandom(nextRandom(2) ? 0xFFFF : 100);
+        check(nextRandom(0x10000), nextRandom(0x10000), duration, nextRandom(Exponential + 1), timebase);
+    }
+}
+
+int main()
+{
+    // Segments up to 65535 ticks are divided by 16-bit limbs, and longer ones bit by bit
+    testTimebase(Milliseconds);
+    testTimebase(Microseconds);
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
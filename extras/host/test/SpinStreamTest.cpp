@@ -0,0 +1,196 @@
+// SpinStreamTest.cpp
+// Spin stream test: checks that streams are spun like the same maps stored in RAM, and their underruns
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define MAPS 2000         // Random maps spun on every timebase
+#define MAX_MAP_POINTS 12 // Max points of a random map
+#define MAX_SEGMENT 2000  // Max duration of a random map segment, in milliseconds
+#define MAX_BUFFER 6      // Max size of the ring buffer of a stream appended while spinning
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from the spin() calls
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Checks a condition, printing the first failures
+static void check(bool condition, const char *test, int map, unsigned long elapsedTime, const char *message)
+{
+    if (condition || failures++ >= 10)
+        return;
+
+    printf("%s, map %d at %lu ticks: %s\n", test, map, elapsedTime, message);
+}
+
+// Checks that the stream spinner reached the same point than the RAM map spinner
+static void checkPoint(const char *test, int map, unsigned long elapsedTime, const SpinPoint *expected, const SpinPoint *spinPoint)
+{
+    if ((expected == NULL) == (spinPoint == NULL) && (expected == NULL || expected->speed == spinPoint->speed))
+        return;
+
+    if (failures++ < 10)
+        printf("%s, map %d at %lu ticks: expected speed %d, got %d\n", test, map, elapsedTime,
+               expected != NULL ? (int)expected->speed : -1, spinPoint != NULL ? (int)spinPoint->speed : -1);
+}
+
+// Spins random maps from RAM and from streams on a timebase, at the same random times. Half of the
+// streams are closed before the spin start, and the other half are appended while spinning
+static void spinRandomMaps(SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner ramSpinner(&motor), streamSpinner(&motor);
+    ramSpinner.timebase(timebase);
+    streamSpinner.timebase(timebase);
+
+    // Short segments on the microseconds timebase, so the spin calls reach the segment ends
+    unsigned long maxSegment = timebase == Microseconds ? MAX_SEGMENT / 100 : MAX_SEGMENT;
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    SpinPoint streamBuffer[MAX_MAP_POINTS + 1];
+    for (int map = 0; map < MAPS; map++)
+    {
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        unsigned long minSegment = maxSegment;
+        spinMap[0].time = 0;
+        spinMap[0].speed = nextRandom(65536);
+        for (uint8_t i = 1; i < mapSize; i++)
+        {
+            uint16_t duration = 1 + nextRandom(maxSegment);
+            spinMap[i].time = spinMap[i - 1].time + duration;
+            spinMap[i].speed = nextRandom(65536);
+            if (duration < minSegment)
+                minSegment = duration;
+        }
+
+        // The stream holds the first segment when it's started, and the first stream point time is ignored
+        bool preloaded = nextRandom(2);
+        SpinStream stream(streamBuffer, preloaded ? mapSize + 1 : 3 + nextRandom(MAX_BUFFER - 2));
+        uint8_t appended = 0;
+        while (appended < mapSize && stream.space() > 0)
+        {
+            uint16_t timeIncrement = appended == 0 ? nextRandom(65536) : spinMap[appended].time - spinMap[appended - 1].time;
+            check(stream.append(spinMap[appended].speed, timeIncrement), "Append", map, 0, "point not appended");
+            appended++;
+        }
+        if (appended == mapSize)
+            stream.close();
+
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *ramPoint = ramSpinner.start(Clockwise, spinMap, mapSize);
+        const SpinPoint *streamPoint = streamSpinner.start(Clockwise, &stream);
+        unsigned long elapsedTime = 0;
+        while (true)
+        {
+            checkPoint(preloaded ? "Preloaded stream" : "Streamed", map, elapsedTime, ramPoint, streamPoint);
+            if (ramPoint == NULL)
+                break;
+
+            // Keep the stream full. A spin() call doesn't pass more than a segment, so it never underruns
+            for (; appended < mapSize && stream.space() > 0; appended++)
+                stream.append(spinMap[appended].speed, spinMap[appended].time - spinMap[appended - 1].time);
+            if (appended == mapSize)
+                stream.close();
+
+            unsigned long interval = nextRandom(4) ? 1 : 1 + nextRandom(minSegment * timebase);
+            elapsedTime += interval;
+            halBenchmark.clock += interval * (1000 / timebase);
+            ramPoint = ramSpinner.spin();
+            streamPoint = streamSpinner.spin();
+        }
+        check(stream.underruns() == 0, "Underruns", map, elapsedTime, "stream underrun");
+    }
+}
+
+// Spins an open stream running out of points: the reached speed is held, and the spin resumes
+// towards the next appended point from the moment it's taken
+static void testUnderrun()
+{
+    NullMotor motor;
+    Spinner ramSpinner(&motor), streamSpinner(&motor);
+    SpinPoint streamBuffer[4];
+    SpinStream stream(streamBuffer, 4);
+    stream.append(1000, 0);
+    stream.append(5000, 100);
+
+    halBenchmark.clock = 0;
+    const SpinPoint *streamPoint = streamSpinner.start(Clockwise, &stream);
+    unsigned long elapsedTime;
+    for (elapsedTime = 1; elapsedTime <= 400; elapsedTime++)
+    {
+        halBenchmark.clock += 1000;
+        streamPoint = streamSpinner.spin();
+    }
+    check(streamPoint != NULL && streamPoint->speed == 5000, "Underrun", 0, elapsedTime, "reached speed not held");
+    check(stream.underruns() == 1, "Underrun", 0, elapsedTime, "underrun not counted once");
+
+    // The RAM map starts when the stream spinner takes the appended point
+    SpinPoint spinMap[2] = {{5000, 0}, {20000, 200}};
+    stream.append(20000, 200);
+    stream.close();
+    halBenchmark.clock += 1000;
+    const SpinPoint *ramPoint = ramSpinner.start(Clockwise, spinMap, 2);
+    streamPoint = streamSpinner.spin();
+    while (true)
+    {
+        checkPoint("Underrun", 0, elapsedTime, ramPoint, streamPoint);
+        if (ramPoint == NULL)
+            break;
+
+        elapsedTime++;
+        halBenchmark.clock += 1000;
+        ramPoint = ramSpinner.spin();
+        streamPoint = streamSpinner.spin();
+    }
+    check(stream.underruns() == 1, "Underrun", 0, elapsedTime, "closed stream counted as an underrun");
+}
+
+// Appends points with zero time increments, only allowed on the first stream point
+static void testZeroTimeIncrement()
+{
+    SpinPoint streamBuffer[4];
+    SpinStream stream(streamBuffer, 4);
+    check(stream.append(1000, 0), "Zero time increment", 0, 0, "first point rejected");
+    check(!stream.append(2000, 0), "Zero time increment", 0, 0, "second point appended");
+    check(stream.append(2000, 1), "Zero time increment", 0, 0, "valid point rejected");
+    check(stream.available() == 2, "Zero time increment", 0, 0, "rejected point stored");
+
+    stream.reset();
+    check(stream.append(1000, 0), "Zero time increment", 0, 0, "first point rejected after reset");
+    stream.close();
+    check(!stream.append(2000, 1), "Zero time increment", 0, 0, "point appended to a closed stream");
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(Milliseconds);
+    spinRandomMaps(Microseconds);
+    testUnderrun();
+    testZeroTimeIncrement();
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
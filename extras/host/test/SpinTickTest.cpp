@@ -0,0 +1,125 @@
+// SpinTickTest.cpp
+// Spin tick test: checks that the speed updates done on consecutive ticks, that only add the segment slope,
+// reach the same speeds than the updates multiplying it by the elapsed time
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define MAPS 1000         // Random maps spun on every timebase
+#define MAX_MAP_POINTS 8  // Max points of a random map
+#define MAX_SEGMENT 8000  // Max duration of a random map segment, in milliseconds
+#define MAX_RUN 2000      // Max consecutive ticks spun between two jumps
+
+/**
+ * Motor ignoring the speeds set by the spinners, that are read from the spin() calls
+ * @class
+ */
+class NullMotor : public MotorInterface
+{
+public:
+    void run(Direction, uint16_t) override {}
+    void stop() override {}
+    void brake() override {}
+};
+
+static int failures;
+
+// Xorshift pseudo-random generator
+static uint32_t randomState = 2463534242u;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % range;
+}
+
+// Checks that a spinner reached the same point than the reference spinner
+static void check(const char *spinner, int map, unsigned long elapsedTime, const SpinPoint *expected, const SpinPoint *spinPoint)
+{
+    if ((expected == NULL) == (spinPoint == NULL) && (expected == NULL || expected->speed == spinPoint->speed))
+        return;
+
+    if (failures++ < 10)
+        printf("Map %d, %s at %lu ticks: expected speed %d, got %d\n", map, spinner, elapsedTime,
+               expected != NULL ? (int)expected->speed : -1, spinPoint != NULL ? (int)spinPoint->speed : -1);
+}
+
+// Spins random maps on a timebase with three spinners: the map and the compiled map are spun in runs
+// of consecutive ticks separated by random jumps, and the reference map only at the end of every run,
+// so that its updates are always done after two ticks or more
+static void spinRandomMaps(SpinTimebase timebase)
+{
+    NullMotor motor;
+    Spinner mapSpinner(&motor), compiledSpinner(&motor), referenceSpinner(&motor);
+    mapSpinner.timebase(timebase);
+    compiledSpinner.timebase(timebase);
+    referenceSpinner.timebase(timebase);
+
+    SpinPoint spinMap[MAX_MAP_POINTS];
+    uint8_t segmentCurves[MAX_MAP_POINTS - 1];
+    CompiledSpinSegment segments[MAX_MAP_POINTS];
+    CompiledSpinMap compiledSpinMap(segments, MAX_MAP_POINTS);
+    for (int map = 0; map < MAPS; map++)
+    {
+        // Short segments as often as long ones
+        uint8_t mapSize = 2 + nextRandom(MAX_MAP_POINTS - 1);
+        spinMap[0].time = 0;
+        spinMap[0].speed = nextRandom(65536);
+        for (uint8_t i = 1; i < mapSize; i++)
+        {
+            spinMap[i].time = spinMap[i - 1].time + 1 + nextRandom(nextRandom(2) ? MAX_SEGMENT : 100);
+            spinMap[i].speed = nextRandom(4) == 0 ? spinMap[i - 1].speed + nextRandom(64) - 32 : nextRandom(65536);
+            segmentCurves[i - 1] = nextRandom(Exponential + 1);
+        }
+        if (!compiledSpinMap.compile(spinMap, mapSize, segmentCurves, timebase))
+        {
+            printf("Map %d not compiled\n", map);
+            failures++;
+            continue;
+        }
+
+        halBenchmark.clock = nextRandom(1000000);
+        const SpinPoint *mapPoint = mapSpinner.start(Clockwise, spinMap, mapSize, segmentCurves);
+        const SpinPoint *compiledPoint = compiledSpinner.start(Clockwise, &compiledSpinMap);
+        const SpinPoint *referencePoint = referenceSpinner.start(Clockwise, spinMap, mapSize, segmentCurves);
+        unsigned long elapsedTime = 0;
+        while (mapPoint != NULL)
+        {
+            // A jump, then a run of consecutive ticks
+            unsigned long jump = 1 + nextRandom(spinMap[mapSize - 1].time * (unsigned long)timebase / 4 + 1);
+            unsigned long run = 1 + nextRandom(MAX_RUN);
+            for (unsigned long tick = 0; tick <= run; tick++)
+            {
+                unsigned long interval = tick == 0 ? jump : 1;
+                elapsedTime += interval;
+                halBenchmark.clock += interval * (1000 / timebase);
+                mapPoint = mapSpinner.spin();
+                compiledPoint = compiledSpinner.spin();
+                check("compiled map", map, elapsedTime, mapPoint, compiledPoint);
+                if (mapPoint == NULL)
+                    break;
+            }
+
+            // A map finished in the middle of a run was already checked against the compiled map
+            if (mapPoint == NULL)
+                break;
+            referencePoint = referenceSpinner.spin();
+            check("map", map, elapsedTime, referencePoint, mapPoint);
+        }
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+    spinRandomMaps(Milliseconds);
+    spinRandomMaps(Microseconds);
+
+    if (failures != 0)
+        printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// VelocityControllerTest.cpp
+// VelocityController test: drives a simulated motor with encoder in closed loop
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <tb6612fng.h>
+
+#define DOUT1 2  // Driver IN1 input
+#define DOUT2 3  // Driver IN2 input
+#define PWMOUT 4 // Driver PWM input
+#define ENCA 5   // Encoder channel A
+#define ENCB 6   // Encoder channel B
+
+#define MAX_COUNTS_PER_SECOND 4000 // Encoder counts per second at full speed
+#define CONTROL_PERIOD 10          // Control period, in milliseconds
+#define SIMULATION_STEP 100        // Simulation step, in microseconds
+
+// Allowed steady state errors, in the speed scale: 1% of the full speed for the simulated velocity,
+// and one encoder count per control period for the measured velocity
+#define SIMULATED_TOLERANCE 655
+#define MEASURED_TOLERANCE (65535L * 1000 / (MAX_COUNTS_PER_SECOND * CONTROL_PERIOD))
+
+static VelocityController *controller;
+static HalMotorPlant plant;
+static int failures;
+
+static void encoderA()
+{
+    controller->encoderEdgeA();
+}
+
+static void encoderB()
+{
+    controller->encoderEdgeB();
+}
+
+// Simulates the motor for a given time, running the controller
+static void simulate(unsigned long milliseconds)
+{
+    for (unsigned long i = 0; i < milliseconds * 1000 / SIMULATION_STEP; i++)
+    {
+        halBenchmark.clock += SIMULATION_STEP;
+        halPlantStep(&plant, SIMULATION_STEP);
+        controller->update();
+    }
+}
+
+// Simulated velocity, in the speed scale
+static long plantVelocity()
+{
+    return (long)((long long)plant.velocity * 65535 / 1000 / MAX_COUNTS_PER_SECOND);
+}
+
+// Checks that a velocity is within the tolerance of its expected value
+static void check(const char *name, uint16_t load, long expected, long velocity, long tolerance)
+{
+    if (velocity >= expected - tolerance && velocity <= expected + tolerance)
+        return;
+
+    printf("%s, load %u: expected velocity %ld, got %ld\n", name, load, expected, velocity);
+    failures++;
+}
+
+// Runs the controller at several setpoints against a motor with a given load
+static void testLoad(uint16_t load)
+{
+    plant.load = load;
+
+    controller->run(Clockwise, 32768);
+    simulate(1000);
+    check("Clockwise measured", load, 32768, controller->velocity(), MEASURED_TOLERANCE);
+    check("Clockwise simulated", load, 32768, plantVelocity(), SIMULATED_TOLERANCE);
+
+    controller->run(CounterClockwise, 16384);
+    simulate(1000);
+    check("Counter-clockwise measured", load, -16384, controller->velocity(), MEASURED_TOLERANCE);
+    check("Counter-clockwise simulated", load, -16384, plantVelocity(), SIMULATED_TOLERANCE);
+
+    // The controller no longer drives the motor once braked
+    controller->brake();
+    simulate(1000);
+    check("Braked simulated", load, 0, plantVelocity(), SIMULATED_TOLERANCE);
+}
+
+static uint32_t randomState = 2463534242u;
+
+// Xorshift pseudo-random generator, so that every run checks the same steps
+static uint32_t random32()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Checks the measured velocity of on time and late control steps against a 64-bit division
+static void testMeasurement(Motor *motor, EncoderPinMap *encoderPinMap)
+{
+    static const unsigned long countsPerSecond[] = {1, 7, 1000, 4000, 65535, 100000, 1000000};
+    static const uint16_t periods[] = {1, 3, 10, 64, 1000, 65535};
+
+    for (uint8_t i = 0; i < sizeof(countsPerSecond) / sizeof(countsPerSecond[0]); i++)
+    {
+        for (uint8_t j = 0; j < sizeof(periods) / sizeof(periods[0]); j++)
+        {
+            VelocityController measuringController(motor, encoderPinMap, countsPerSecond[i], periods[j]);
+            int64_t countScale = 65535000000ULL / countsPerSecond[i];
+            unsigned long period = (unsigned long)periods[j] * 1000;
+
+            for (int k = 0; k < 200; k++)
+            {
+                // Up to twice the full speed counts, clockwise or counter-clockwise, on time or late by up to half a period
+                unsigned long maxCounts = countsPerSecond[i] * periods[j] / 500;
+                long counts = random32() % ((maxCounts < 3000 ? maxCounts : 3000) + 1);
+                halBenchmark.pins[ENCA] = 1;
+                halBenchmark.pins[ENCB] = random32() & 1;
+                for (long n = 0; n < counts; n++)
+                    measuringController.encoderEdgeA();
+                if (halBenchmark.pins[ENCB])
+                    counts = -counts;
+                unsigned long elapsedTime = period + ((k & 1) ? random32() % (period / 2 + 1) : 0);
+                halBenchmark.clock += elapsedTime;
+                measuringController.update();
+
+                long expected = (long)(counts * countScale / (int64_t)elapsedTime);
+                if (measuringController.velocity() != expected && ++failures <= 10)
+                    printf("Measurement, %lu counts per second, period %u, %ld counts in %lu us: expected velocity %ld, got %ld\n",
+                           countsPerSecond[i], periods[j], counts, elapsedTime, expected, measuringController.velocity());
+            }
+        }
+    }
+}
+
+int main()
+{
+    halBenchmark.fakeClock = true;
+    halBenchmark.fakePins = true;
+
+    PinMap pinMap;
+    pinMap.in1 = DOUT1;
+    pinMap.in2 = DOUT2;
+    pinMap.pwm = PWMOUT;
+    Motor motor(&pinMap);
+
+    EncoderPinMap encoderPinMap;
+    encoderPinMap.a = ENCA;
+    encoderPinMap.b = ENCB;
+    VelocityController velocityController(&motor, &encoderPinMap, MAX_COUNTS_PER_SECOND, CONTROL_PERIOD);
+    controller = &velocityController;
+    controller->tune(128, 64, 0);
+
+    // Simulated motor with a time constant of 50 milliseconds
+    plant.in1 = DOUT1;
+    plant.in2 = DOUT2;
+    plant.pwm = PWMOUT;
+    plant.encoderA = ENCA;
+    plant.encoderB = ENCB;
+    plant.encoderAISR = encoderA;
+    plant.encoderBISR = encoderB;
+    plant.freeSpeed = MAX_COUNTS_PER_SECOND;
+    plant.timeConstant = 50;
+
+    // No load, and loads taking 30% and 45% of the free speed
+    testLoad(0);
+    testLoad(19660);
+    testLoad(29491);
+
+    testMeasurement(&motor, &encoderPinMap);
+
+    return failures == 0 ? 0 : 1;
+}
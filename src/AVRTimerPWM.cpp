@@ -0,0 +1,203 @@
+// AVRTimerPWM.cpp
+// Implementation of the AVRTimerPWM class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "AVRTimerPWM.h"
+
+#if defined(AVR_TIMER_PWM)
+
+/**
+ * Registers of a 16-bit timer
+ * @typedef {struct} AVRTimerRegisters
+ * @property {volatile uint8_t*} controlA - Control register A (TCCRnA)
+ * @property {volatile uint8_t*} controlB - Control register B (TCCRnB)
+ * @property {volatile uint16_t*} counter - Counter register (TCNTn)
+ * @property {volatile uint16_t*} top - Input capture register, setting the top value (ICRn)
+ */
+struct AVRTimerRegisters
+{
+    volatile uint8_t *controlA;
+    volatile uint8_t *controlB;
+    volatile uint16_t *counter;
+    volatile uint16_t *top;
+};
+
+/**
+ * Output compare channel of a 16-bit timer connected to an Arduino pin
+ * @typedef {struct} AVRTimerChannel
+ * @property {pin_size_t} pin - Arduino pin
+ * @property {uint8_t} timer - Index of the timer in kAVRTimers
+ * @property {volatile uint16_t*} compare - Output compare register (OCRnx)
+ * @property {uint8_t} connect - Control register A bit connecting the channel to its pin (COMnx1)
+ */
+struct AVRTimerChannel
+{
+    pin_size_t pin;
+    uint8_t timer;
+    volatile uint16_t *compare;
+    uint8_t connect;
+};
+
+#if AVR_TIMER_PWM_TIMERS == 1
+static const AVRTimerRegisters kAVRTimers[] = {{&TCCR1A, &TCCR1B, &TCNT1, &ICR1}};
+#else
+static const AVRTimerRegisters kAVRTimers[] = {{&TCCR1A, &TCCR1B, &TCNT1, &ICR1}, {&TCCR3A, &TCCR3B, &TCNT3, &ICR3}};
+#endif
+
+#if defined(__AVR_ATmega32U4__)
+// Timer1 outputs on pins 9, 10 and 11, Timer3 output on pin 5 (Arduino Leonardo, Micro)
+static const AVRTimerChannel kAVRTimerChannels[] = {
+    {9, 0, &OCR1A, _BV(COM1A1)}, {10, 0, &OCR1B, _BV(COM1B1)}, {11, 0, &OCR1C, _BV(COM1C1)}, {5, 1, &OCR3A, _BV(COM3A1)}};
+#elif defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+// Timer1 outputs on pins 11 and 12, Timer3 outputs on pins 5, 2 and 3 (Arduino Mega)
+static const AVRTimerChannel kAVRTimerChannels[] = {
+    {11, 0, &OCR1A, _BV(COM1A1)}, {12, 0, &OCR1B, _BV(COM1B1)}, {5, 1, &OCR3A, _BV(COM3A1)}, {2, 1, &OCR3B, _BV(COM3B1)}, {3, 1, &OCR3C, _BV(COM3C1)}};
+#else
+// Timer1 outputs on pins 9 and 10 (Arduino Uno, Nano, Pro Mini)
+static const AVRTimerChannel kAVRTimerChannels[] = {{9, 0, &OCR1A, _BV(COM1A1)}, {10, 0, &OCR1B, _BV(COM1B1)}};
+#endif
+
+// Prescaler of every clock select value, as a power of two
+static const uint8_t kAVRPrescalerShift[] = {0, 0, 3, 6, 8, 10};
+
+#if AVR_TIMER_PWM_TIMERS == 1
+AVRTimerPWM AVRTimerPWM::timers_[AVR_TIMER_PWM_TIMERS] = {AVRTimerPWM(0)};
+#else
+AVRTimerPWM AVRTimerPWM::timers_[AVR_TIMER_PWM_TIMERS] = {AVRTimerPWM(0), AVRTimerPWM(1)};
+#endif
+
+/**
+ * Returns the timer channel connected to an Arduino pin
+ * @param {pin_size_t} pin - Arduino pin
+ * @returns {const AVRTimerChannel*} Timer channel, or NULL if the pin is not a 16-bit timer output
+ */
+static const AVRTimerChannel *findAVRTimerChannel(pin_size_t pin)
+{
+    for (uint8_t i = 0; i < sizeof(kAVRTimerChannels) / sizeof(kAVRTimerChannels[0]); i++)
+    {
+        if (kAVRTimerChannels[i].pin == pin)
+            return &kAVRTimerChannels[i];
+    }
+    return NULL;
+}
+
+// Public functions definition
+
+/**
+ * Generates the PWM signal of an output at a given frequency
+ * @param {pin_size_t} pin - Arduino output connected to a 16-bit timer output compare channel
+ * @param {uint32_t} frequency - PWM frequency, in Hertzs
+ * @returns {AVRTimerPWM*} Backend generating the output, or NULL if error
+ */
+AVRTimerPWM *AVRTimerPWM::attach(pin_size_t pin, uint32_t frequency)
+{
+    const AVRTimerChannel *channel = findAVRTimerChannel(pin);
+    if (channel == NULL || frequency == 0)
+        return NULL;
+
+    // The lowest prescaler whose top value fits in 16 bits gives the highest resolution.
+    // In phase and frequency correct mode the timer counts up and down, so the PWM period
+    // is twice the top value
+    uint8_t clockSelect;
+    uint32_t top = 0;
+    for (clockSelect = 1; clockSelect < sizeof(kAVRPrescalerShift); clockSelect++)
+    {
+        top = ((F_CPU >> kAVRPrescalerShift[clockSelect]) / 2 + frequency / 2) / frequency;
+        if (top <= 0xFFFF)
+            break;
+    }
+    if (top < kMinTop || top > 0xFFFF)
+        return NULL;
+
+    // A timer already set up is shared by all its outputs, so they must use the same frequency
+    AVRTimerPWM *timer = &timers_[channel->timer];
+    uint8_t controlB = _BV(WGM13) | clockSelect;
+    if (timer->controlB_ != 0 && (timer->controlB_ != controlB || timer->top_ != top))
+        return NULL;
+
+    pinMode(pin, OUTPUT);
+    HalInterruptState interruptState = halDisableInterrupts();
+    *channel->compare = 0;
+    timer->connected_ |= channel->connect;
+    const AVRTimerRegisters *registers = &kAVRTimers[channel->timer];
+    if (*registers->controlB == controlB && timer->controlB_ == controlB)
+    {
+        // The timer keeps running, so the outputs already attached don't glitch
+        *registers->controlA |= channel->connect;
+    }
+    else
+    {
+        timer->controlB_ = controlB;
+        timer->top_ = top;
+        timer->setUp_();
+    }
+    halRestoreInterrupts(interruptState);
+
+    return timer;
+}
+
+/**
+ * Returns the PWM frequency generated by the timer
+ * @returns {uint32_t} Frequency, in Hertzs, rounded to the nearest integer
+ */
+uint32_t AVRTimerPWM::frequency()
+{
+    if (controlB_ == 0)
+        return 0;
+
+    uint32_t halfClock = (F_CPU >> kAVRPrescalerShift[controlB_ & 0x07]) / 2;
+    return (halfClock + top_ / 2) / top_;
+}
+
+/**
+ * Returns the duty cycle value setting the output continuously high
+ * @returns {uint16_t} Timer top value
+ */
+uint16_t AVRTimerPWM::resolution()
+{
+    return top_;
+}
+
+/**
+ * Sets the duty cycle of an output
+ * @param {pin_size_t} pin - Arduino output attached to the timer
+ * @param {uint16_t} duty - Duty cycle, from 0 to resolution()
+ */
+void AVRTimerPWM::write(pin_size_t pin, uint16_t duty)
+{
+    const AVRTimerChannel *channel = findAVRTimerChannel(pin);
+    if (channel == NULL || channel->timer != timer_)
+        return;
+
+    // 16-bit registers are written through a temporary register shared by all the timers,
+    // so the write must not be interrupted
+    HalInterruptState interruptState = halDisableInterrupts();
+
+    // The Arduino core init() sets up the timers again when the backend is attached
+    // by a global object, so the timer mode is checked on every write
+    if (*kAVRTimers[timer_].controlB != controlB_)
+        setUp_();
+    *channel->compare = duty;
+    halRestoreInterrupts(interruptState);
+}
+
+// Private functions definition
+
+/**
+ * Sets up the timer in phase and frequency correct mode with the stored top value and clock select
+ * @note Must be called with interrupts disabled
+ */
+void AVRTimerPWM::setUp_()
+{
+    const AVRTimerRegisters *registers = &kAVRTimers[timer_];
+
+    // The timer is stopped while it's set up
+    *registers->controlB = 0;
+    *registers->controlA = connected_;
+    *registers->counter = 0;
+    *registers->top = top_;
+    *registers->controlB = controlB_;
+}
+
+#endif
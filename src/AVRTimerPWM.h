@@ -0,0 +1,80 @@
+// AVRTimerPWM.h
+// Header file for AVRTimerPWM class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef AVR_TIMER_PWM_H
+#define AVR_TIMER_PWM_H
+
+#include "PWMBackend.h"
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+// Timer1 (Arduino Uno, Nano, Pro Mini)
+#define AVR_TIMER_PWM
+#define AVR_TIMER_PWM_TIMERS 1
+#elif defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+// Timer1 and Timer3 (Arduino Leonardo, Micro, Mega)
+#define AVR_TIMER_PWM
+#define AVR_TIMER_PWM_TIMERS 2
+#endif
+
+#if defined(AVR_TIMER_PWM)
+
+/**
+ * PWM backend generating the driver PWM inputs with the 16-bit timers of the AVR processors
+ * @class
+ * @note The timers run in phase and frequency correct mode, with the top value set by the input capture
+ *  register, so both the PWM frequency and its resolution (the top value) are set by the program
+ */
+class AVRTimerPWM : public PWMBackend
+{
+public:
+    /**
+     * Generates the PWM signal of an output at a given frequency
+     * @param {pin_size_t} pin - Arduino output connected to a 16-bit timer output compare channel
+     * @param {uint32_t} frequency - PWM frequency, in Hertzs
+     * @returns {AVRTimerPWM*} Backend generating the output, or NULL if the pin is not a 16-bit timer output,
+     *  the frequency doesn't allow an 8-bit resolution at least, or the timer already runs at another frequency
+     * @note The output duty cycle is initially 0
+     */
+    static AVRTimerPWM *attach(pin_size_t pin, uint32_t frequency);
+
+    /**
+     * Returns the PWM frequency generated by the timer
+     * @returns {uint32_t} Frequency, in Hertzs, rounded to the nearest integer
+     */
+    uint32_t frequency();
+
+    /**
+     * Returns the duty cycle value setting the output continuously high
+     * @returns {uint16_t} Timer top value
+     */
+    uint16_t resolution() override;
+
+    /**
+     * Sets the duty cycle of an output
+     * @param {pin_size_t} pin - Arduino output attached to the timer
+     * @param {uint16_t} duty - Duty cycle, from 0 to resolution()
+     */
+    void write(pin_size_t pin, uint16_t duty) override;
+
+private:
+    // Lowest accepted top value, matching the 8-bit resolution of analogWrite
+    static const uint16_t kMinTop = 255;
+
+    uint8_t timer_;
+    // Control register B value (waveform generation mode and clock select), or 0 if the timer is not set up
+    uint8_t controlB_;
+    // Output compare channels connected to their pins, as control register A bits
+    uint8_t connected_;
+    uint16_t top_;
+
+    static AVRTimerPWM timers_[AVR_TIMER_PWM_TIMERS];
+
+    constexpr AVRTimerPWM(uint8_t timer) : timer_(timer), controlB_(0), connected_(0), top_(0) {}
+    void setUp_();
+};
+
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+// CompiledSpinMap.cpp
+// Implementation of the CompiledSpinMap class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "CompiledSpinMap.h"
+
+// Public functions definition
+
+/**
+ * Creates an empty compiled spin map
+ * @constructor
+ * @param {CompiledSpinSegment[]} buffer - Buffer storing the compiled segments
+ * @param {uint8_t} bufferSize - Number of compiled segments of the buffer
+ */
+CompiledSpinMap::CompiledSpinMap(CompiledSpinSegment buffer[], uint8_t bufferSize) : segments_(buffer), bufferSize_(bufferSize)
+{
+    size_ = 0;
+    timebase_ = Milliseconds;
+}
+
+/**
+ * Compiles a spin map with linear segments
+ * @param {const SpinPoint[]} spinMap - Spin map
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {SpinTimebase} timebase - Timebase of the spinners spinning the compiled map
+ * @returns {bool} True if the map was compiled
+ */
+bool CompiledSpinMap::compile(const SpinPoint spinMap[], uint8_t spinMapSize, SpinTimebase timebase)
+{
+    return compile(spinMap, spinMapSize, NULL, timebase);
+}
+
+/**
+ * Compiles a spin map and the curves of its segments
+ * @param {const SpinPoint[]} spinMap - Spin map
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, or null if all the segments are linear
+ * @param {SpinTimebase} timebase - Timebase of the spinners spinning the compiled map
+ * @returns {bool} True if the map was compiled
+ */
+bool CompiledSpinMap::compile(const SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[], SpinTimebase timebase)
+{
+    size_ = 0;
+    if (spinMapSize > bufferSize_ || !Spinner::checkSpinMap_(spinMap, Spinner::kRamMap, spinMapSize, segmentCurves))
+        return false;
+
+    for (uint8_t i = 0; i < spinMapSize; i++)
+    {
+        CompiledSpinSegment *segment = &segments_[i];
+        segment->speed = spinMap[i].speed;
+        segment->time = spinMap[i].time;
+
+        // The last map point doesn't start any segment
+        if (i == spinMapSize - 1)
+        {
+            segment->curve = Linear;
+            segment->descending = false;
+            segment->slope[0] = segment->slope[1] = segment->slope[2] = segment->slope[3] = 0;
+            break;
+        }
+
+        segment->curve = segmentCurves != NULL ? segmentCurves[i] : (uint8_t)Linear;
+        segment->descending = spinMap[i + 1].speed < spinMap[i].speed;
+        Spinner::getSlope_(spinMap[i].speed, spinMap[i + 1].speed, segment->curve,
+                           (unsigned long)(spinMap[i + 1].time - spinMap[i].time) * timebase, segment->slope);
+    }
+
+    timebase_ = timebase;
+    size_ = spinMapSize;
+    return true;
+}
+
+/**
+ * Returns the number of compiled map points
+ * @returns {uint8_t} Number of points of the compiled map
+ */
+uint8_t CompiledSpinMap::size()
+{
+    return size_;
+}
+
+/**
+ * Returns the timebase the map was compiled for
+ * @returns {SpinTimebase} Timebase
+ */
+SpinTimebase CompiledSpinMap::timebase()
+{
+    return timebase_;
+}
@@ -0,0 +1,85 @@
+// CompiledSpinMap.h
+// Header file for CompiledSpinMap class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef COMPILED_SPIN_MAP_H
+#define COMPILED_SPIN_MAP_H
+
+#include "Spinner.h"
+
+/**
+ * Compiled spin map segment
+ * @typedef {struct} CompiledSpinSegment
+ * @property {uint16_t} speed - Speed of the map point starting the segment
+ * @property {uint16_t} time - Time, in milliseconds, of the map point starting the segment
+ * @property {uint16_t[]} slope - Absolute speed increment (or, on curve segments, segment progress) per timebase tick, in Q48 fixed point split in 16-bit limbs
+ * @property {uint8_t} curve - SpinCurve of the segment
+ * @property {bool} descending - True if the segment speed decreases
+ */
+struct CompiledSpinSegment
+{
+    uint16_t speed;
+    uint16_t time;
+    uint16_t slope[4];
+    uint8_t curve;
+    bool descending;
+};
+
+/**
+ * Spin map whose segment slopes are calculated once, before spinning it
+ * @class
+ * @note A compiled map is spun without any division, neither on spin updates nor on segment changes
+ */
+class CompiledSpinMap
+{
+public:
+    /**
+     * Creates an empty compiled spin map
+     * @constructor
+     * @param {CompiledSpinSegment[]} buffer - Buffer storing the compiled segments, one per spin map point
+     * @param {uint8_t} bufferSize - Number of compiled segments of the buffer
+     */
+    CompiledSpinMap(CompiledSpinSegment buffer[], uint8_t bufferSize);
+
+    /**
+     * Compiles a spin map with linear segments
+     * @param {const SpinPoint[]} spinMap - Spin map containing a list of spin points
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @param {SpinTimebase} timebase - Timebase of the spinners spinning the compiled map
+     * @returns {bool} True if the map was compiled, false if it doesn't pass the spin map integrity check or doesn't fit in the buffer
+     */
+    bool compile(const SpinPoint spinMap[], uint8_t spinMapSize, SpinTimebase timebase);
+
+    /**
+     * Compiles a spin map and the curves of its segments
+     * @param {const SpinPoint[]} spinMap - Spin map containing a list of spin points
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, ie, spinMapSize - 1 curves
+     * @param {SpinTimebase} timebase - Timebase of the spinners spinning the compiled map
+     * @returns {bool} True if the map was compiled, false if it doesn't pass the spin map integrity check or doesn't fit in the buffer
+     */
+    bool compile(const SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[], SpinTimebase timebase);
+
+    /**
+     * Returns the number of compiled map points
+     * @returns {uint8_t} Number of points of the compiled map, or zero if no map was compiled
+     */
+    uint8_t size();
+
+    /**
+     * Returns the timebase the map was compiled for
+     * @returns {SpinTimebase} Timebase
+     */
+    SpinTimebase timebase();
+
+private:
+    friend class Spinner;
+
+    CompiledSpinSegment *segments_;
+    uint8_t bufferSize_;
+    uint8_t size_;
+    SpinTimebase timebase_;
+};
+
+#endif
@@ -20,7 +20,7 @@ Driver::Driver(pin_size_t stbyPin) : Driver(stbyPin, false) {}
  * @param {pin_size_t} stbyPin - Arduino digital output connected to the driver STBY input
  * @param {bool} standbyOn - Boolean value indicating if the driver is set in standby mode by the constructor
  */
-Driver::Driver(pin_size_t stbyPin, bool standByOn) : stbyPin_(stbyPin)
+Driver::Driver(pin_size_t stbyPin, bool standByOn) : stbyPin_(stbyPin), motorA_(NULL), motorB_(NULL), skew_(0)
 {
     // Initialize the arduino pin
     pinMode(stbyPin_, OUTPUT);
@@ -29,6 +29,19 @@ Driver::Driver(pin_size_t stbyPin, bool standByOn) : stbyPin_(stbyPin)
     Driver::standBy(standByOn);
 }
 
+/**
+ * Creates a TB6612FNG driver whose two channels are updated together
+ * @constructor
+ * @param {pin_size_t} stbyPin - Arduino digital output connected to the driver STBY input
+ * @param {Motor*} motorA - Motor driven by the driver channel A
+ * @param {Motor*} motorB - Motor driven by the driver channel B
+ */
+Driver::Driver(pin_size_t stbyPin, Motor *motorA, Motor *motorB) : Driver(stbyPin, false)
+{
+    motorA_ = motorA;
+    motorB_ = motorB;
+}
+
 /**
  * Manages the driver standby mode
  * @param {bool} standByOn - True to set the driver in standby mode, else false
@@ -36,7 +49,7 @@ Driver::Driver(pin_size_t stbyPin, bool standByOn) : stbyPin_(stbyPin)
 void Driver::standBy(bool standByOn)
 {
     // Set the right outpuy value
-    digitalWrite(stbyPin_, (standByOn ? LOW : HIGH));
+    halDigitalWrite(stbyPin_, !standByOn);
 }
 
 /**
@@ -46,5 +59,81 @@ void Driver::standBy(bool standByOn)
 bool Driver::standBy()
 {
     // Set the right outpu value
-    return (digitalRead(stbyPin_) == LOW);
+    return !halDigitalRead(stbyPin_);
+}
+
+/**
+ * Runs both driver channels in a single batch
+ * @param {Direction} directionA - Channel A motor rotation direction
+ * @param {uint16_t} speedA - Channel A motor rotation speed, from 1 to 65535
+ * @param {Direction} directionB - Channel B motor rotation direction
+ * @param {uint16_t} speedB - Channel B motor rotation speed, from 1 to 65535
+ */
+void Driver::run(Direction directionA, uint16_t speedA, Direction directionB, uint16_t speedB)
+{
+    if (motorA_ == NULL || motorB_ == NULL)
+        return;
+
+    // Work out which outputs change, and their values, before writing any of them
+    bool inputsA = motorA_->enterRunMode_(directionA);
+    bool inputsB = motorB_->enterRunMode_(directionB);
+    uint16_t dutyA, dutyB;
+    bool pwmA = speedA > 0 && motorA_->scaleDuty_(speedA, &dutyA);
+    bool pwmB = speedB > 0 && motorB_->scaleDuty_(speedB, &dutyB);
+    if (!inputsA && !inputsB && !pwmA && !pwmB)
+    {
+        skew_ = 0;
+        return;
+    }
+
+    // Nothing can run between the writes of both channels. Both duty cycles are written
+    // within a few microseconds, so double-buffered compare registers load them on the same PWM period
+    // unless the period ends right between both writes
+    HalInterruptState interruptState = halDisableInterrupts();
+    unsigned long startMicros = halMicros();
+    writeInputs_(inputsA, directionA, inputsB, directionB);
+    if (pwmA)
+        motorA_->writePWM_(&motorA_->pinMap_, dutyA);
+    if (pwmB)
+        motorB_->writePWM_(&motorB_->pinMap_, dutyB);
+    skew_ = halMicros() - startMicros;
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Returns the skew between the channels in the last batch update
+ * @returns {unsigned long} Microseconds from the first to the last output write of the last run() call
+ */
+unsigned long Driver::skew()
+{
+    return skew_;
+}
+
+// Private functions
+
+/**
+ * Writes the direction inputs of both channels
+ * @param {bool} writeA - True to write the channel A inputs, else false
+ * @param {Direction} directionA - Channel A motor rotation direction
+ * @param {bool} writeB - True to write the channel B inputs, else false
+ * @param {Direction} directionB - Channel B motor rotation direction
+ */
+void Driver::writeInputs_(bool writeA, Direction directionA, bool writeB, Direction directionB)
+{
+#if defined(HAL_PORT_OUTPUTS)
+    // If the four inputs share a port, both channels are set with a single write
+    HalOutput *a1 = &motorA_->in1Output_, *a2 = &motorA_->in2Output_;
+    HalOutput *b1 = &motorB_->in1Output_, *b2 = &motorB_->in2Output_;
+    if (writeA && writeB && a1->port == a2->port && a1->port == b1->port && a1->port == b2->port)
+    {
+        bool clockwiseA = directionA == Clockwise, clockwiseB = directionB == Clockwise;
+        halWritePort(a1->port, a1->mask | a2->mask | b1->mask | b2->mask,
+                     (clockwiseA ? a1->mask : a2->mask) | (clockwiseB ? b1->mask : b2->mask));
+        return;
+    }
+#endif
+    if (writeA)
+        motorA_->setInputs_(&motorA_->pinMap_, directionA == Clockwise, directionA != Clockwise);
+    if (writeB)
+        motorB_->setInputs_(&motorB_->pinMap_, directionB == Clockwise, directionB != Clockwise);
 }
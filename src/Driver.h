@@ -6,7 +6,7 @@
 #ifndef DRIVER_H
 #define DRIVER_H
 
-#include <Arduino.h>
+#include "Motor.h"
 
 /**
  * Represents a TB6612FNG driver
@@ -33,6 +33,17 @@ public:
      */
     Driver(pin_size_t stbyPin, bool standbyOn);
 
+    /**
+     * Creates a TB6612FNG driver whose two channels are updated together
+     * @constructor
+     * @param {pin_size_t} stbyPin - Arduino digital output connected to the driver STBY input
+     * @param {Motor*} motorA - Motor driven by the driver channel A
+     * @param {Motor*} motorB - Motor driven by the driver channel B
+     * @note The pin mode will be initialized by the class constructor
+     * @note The driver WILL BE automatically set in NON standby mode
+     */
+    Driver(pin_size_t stbyPin, Motor *motorA, Motor *motorB);
+
     /**
      * Manages the driver standby mode
      * @param {bool} standByOn - True to set the driver in standby mode, else false
@@ -45,8 +56,30 @@ public:
      */
     bool standBy();
 
+    /**
+     * Runs both driver channels in a single batch
+     * @param {Direction} directionA - Channel A motor rotation direction
+     * @param {uint16_t} speedA - Channel A motor rotation speed, from 1 to 65535
+     * @param {Direction} directionB - Channel B motor rotation direction
+     * @param {uint16_t} speedB - Channel B motor rotation speed, from 1 to 65535
+     * @note The outputs of both channels are written back-to-back with interrupts disabled,
+     *  the direction inputs with a single write if they all share a port
+     */
+    void run(Direction directionA, uint16_t speedA, Direction directionB, uint16_t speedB);
+
+    /**
+     * Returns the skew between the channels in the last batch update
+     * @returns {unsigned long} Microseconds from the first to the last output write of the last run() call
+     */
+    unsigned long skew();
+
 private:
     pin_size_t stbyPin_;
+    Motor *motorA_;
+    Motor *motorB_;
+    unsigned long skew_;
+
+    void writeInputs_(bool writeA, Direction directionA, bool writeB, Direction directionB);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+// Hal.cpp
+// Implementation of the hardware access layer used by the library classes
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "Hal.h"
+
+#if defined(TB6612FNG_BENCHMARK)
+// Benchmark stand-in state, zero initialized: real clock and pins are used by default
+HalBenchmark halBenchmark;
+#endif
+
+#if !defined(__AVR__) && !defined(__arm__)
+// No critical section started
+volatile uint8_t halCriticalSections;
+#endif
+
+#if defined(TB6612FNG_BENCHMARK)
+/**
+ * Advances the simulation of a motor, raising its encoder edges
+ * @param {HalMotorPlant*} plant - Simulated motor
+ * @param {unsigned long} elapsedMicros - Simulated time, in microseconds
+ * @note The motor is modelled as a first order system, whose velocity approaches the velocity
+ *  set by the driver outputs. Short-braking slows it down faster than coasting
+ */
+void halPlantStep(HalMotorPlant *plant, unsigned long elapsedMicros)
+{
+    long long elapsedTime = elapsedMicros;
+    bool in1 = halDigitalRead(plant->in1);
+    bool in2 = halDigitalRead(plant->in2);
+    long long targetVelocity = 0;
+    long long timeConstant = (long long)plant->timeConstant * 1000;
+    if (in1 != in2)
+    {
+        long long duty = plant->pwm < TB6612FNG_BENCHMARK_PINS ? halBenchmark.pins[plant->pwm] : 0;
+        targetVelocity = (long long)plant->freeSpeed * 1000 * duty / 255 * (65535 - plant->load) / 65535;
+        if (in2)
+            targetVelocity = -targetVelocity;
+    }
+    else if (in1)
+        timeConstant /= 4;
+    else
+        timeConstant *= 4;
+
+    // Backward Euler step, stable whatever the elapsed time
+    plant->velocity += (targetVelocity - plant->velocity) * elapsedTime / (timeConstant + elapsedTime);
+
+    // Raise an encoder edge per travelled count. Channel A leads channel B when the position increases
+    plant->phase += plant->velocity * elapsedTime % 1000000000;
+    long counts = plant->velocity * elapsedTime / 1000000000 + plant->phase / 1000000000;
+    plant->phase %= 1000000000;
+    for (; counts != 0; counts += counts > 0 ? -1 : 1)
+    {
+        plant->position += counts > 0 ? 1 : -1;
+
+        // Quadrature states 00, 10, 11, 01 (channels A and B)
+        uint8_t state = plant->position & 3;
+        bool a = state == 1 || state == 2;
+        bool b = state >= 2;
+        if (a != halDigitalRead(plant->encoderA))
+        {
+            halBenchmark.pins[plant->encoderA] = a;
+            if (plant->encoderAISR)
+                plant->encoderAISR();
+        }
+        else
+        {
+            halBenchmark.pins[plant->encoderB] = b;
+            if (plant->encoderBISR)
+                plant->encoderBISR();
+        }
+    }
+}
+#endif
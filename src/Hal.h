@@ -0,0 +1,304 @@
+// Hal.h
+// Header file for the hardware access layer used by the library classes
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+
+#if defined(TB6612FNG_BENCHMARK)
+
+#ifndef TB6612FNG_BENCHMARK_PINS
+#define TB6612FNG_BENCHMARK_PINS 32
+#endif
+
+/**
+ * Benchmark stand-in for the Arduino clock and pins
+ * @typedef {struct} HalBenchmark
+ * @property {bool} fakeClock - True to replace millis() and micros() with the fake clock
+ * @property {unsigned long} clock - Fake clock value, in microseconds
+ * @property {bool} fakePins - True to record the pin writes instead of driving the Arduino outputs
+ * @property {uint16_t[]} pins - Last value written to every pin while fakePins is set
+ * @property {uint32_t} pinWrites - Number of digital and analog pin writes performed by the library
+ * @property {uint32_t} floatOps - Number of floating point operations performed by the library
+ */
+struct HalBenchmark
+{
+    bool fakeClock;
+    unsigned long clock;
+    bool fakePins;
+    uint16_t pins[TB6612FNG_BENCHMARK_PINS];
+    uint32_t pinWrites;
+    uint32_t floatOps;
+};
+
+extern HalBenchmark halBenchmark;
+
+#define HAL_COUNT_FLOAT_OPS(count) (halBenchmark.floatOps += (count))
+#define HAL_COUNT_PIN_WRITE() (halBenchmark.pinWrites++)
+
+/**
+ * Records a pin write in the benchmark stand-in
+ * @param {pin_size_t} pin - Written pin
+ * @param {uint16_t} value - Written value
+ * @returns {bool} True if the write was recorded and the real output must not be driven
+ */
+inline bool halFakeWrite(pin_size_t pin, uint16_t value)
+{
+    halBenchmark.pinWrites++;
+    if (!halBenchmark.fakePins)
+        return false;
+
+    if (pin < TB6612FNG_BENCHMARK_PINS)
+        halBenchmark.pins[pin] = value;
+    return true;
+}
+
+/**
+ * Simulated DC motor with a quadrature encoder, driven through the benchmark stand-in pins
+ * @typedef {struct} HalMotorPlant
+ * @property {pin_size_t} in1 - Driver IN1 input the motor is driven by
+ * @property {pin_size_t} in2 - Driver IN2 input the motor is driven by
+ * @property {pin_size_t} pwm - Driver PWM input the motor is driven by, with 8-bit duty cycle
+ * @property {pin_size_t} encoderA - Encoder channel A output
+ * @property {pin_size_t} encoderB - Encoder channel B output
+ * @property {void(*)()} encoderAISR - Interrupt service routine called on every channel A edge, or null
+ * @property {void(*)()} encoderBISR - Interrupt service routine called on every channel B edge, or null
+ * @property {long} freeSpeed - Encoder counts per second at full duty cycle without load
+ * @property {uint16_t} timeConstant - Mechanical time constant, in milliseconds
+ * @property {uint16_t} load - Load, as the lost fraction of the free speed, from 0 (no load) to 65535 (stalled)
+ * @property {long} velocity - Simulated velocity, in thousandths of encoder count per second
+ * @property {long} position - Simulated position, in encoder counts
+ * @property {long} phase - Simulated position fraction, in billionths of encoder count
+ */
+struct HalMotorPlant
+{
+    pin_size_t in1;
+    pin_size_t in2;
+    pin_size_t pwm;
+    pin_size_t encoderA;
+    pin_size_t encoderB;
+    void (*encoderAISR)();
+    void (*encoderBISR)();
+    long freeSpeed;
+    uint16_t timeConstant;
+    uint16_t load;
+    long velocity;
+    long position;
+    long phase;
+};
+
+/**
+ * Advances the simulation of a motor, raising its encoder edges
+ * @param {HalMotorPlant*} plant - Simulated motor
+ * @param {unsigned long} elapsedMicros - Simulated time, in microseconds
+ */
+void halPlantStep(HalMotorPlant *plant, unsigned long elapsedMicros);
+
+#else
+
+#define HAL_COUNT_FLOAT_OPS(count)
+#define HAL_COUNT_PIN_WRITE()
+
+#endif
+
+/**
+ * Interrupts enabled state saved by halDisableInterrupts()
+ * @typedef {uint32_t} HalInterruptState
+ */
+typedef uint32_t HalInterruptState;
+
+#if !defined(__AVR__) && !defined(__arm__)
+// Nesting depth of the critical sections, on cores whose interrupts state cannot be read
+extern volatile uint8_t halCriticalSections;
+#endif
+
+/**
+ * Disables the interrupts, starting a critical section
+ * @returns {HalInterruptState} Interrupts state before disabling them
+ */
+inline HalInterruptState halDisableInterrupts()
+{
+#if defined(__AVR__)
+    HalInterruptState state = SREG;
+    cli();
+    return state;
+#elif defined(__arm__)
+    HalInterruptState state = __get_PRIMASK();
+    __disable_irq();
+    return state;
+#else
+    // The interrupts state cannot be read through the Arduino API: critical sections are counted,
+    // so that nested ones don't enable the interrupts when they end
+    noInterrupts();
+    return halCriticalSections++;
+#endif
+}
+
+/**
+ * Restores the interrupts state saved when a critical section was started
+ * @param {HalInterruptState} state - Interrupts state returned by halDisableInterrupts()
+ */
+inline void halRestoreInterrupts(HalInterruptState state)
+{
+#if defined(__AVR__)
+    SREG = state;
+#elif defined(__arm__)
+    __set_PRIMASK(state);
+#else
+    // Only the outermost critical section enables the interrupts.
+    // On these cores, critical sections must not be started from interrupt service routines
+    halCriticalSections = state;
+    if (state == 0)
+        interrupts();
+#endif
+}
+
+/**
+ * Prevents the compiler from moving memory accesses across this point
+ * @note Used for publishing data shared with interrupt service routines without a critical section
+ */
+inline void halCompilerBarrier()
+{
+    __asm__ __volatile__("" ::: "memory");
+}
+
+/**
+ * Returns the number of milliseconds since the board started
+ * @returns {unsigned long} Elapsed milliseconds
+ */
+inline unsigned long halMillis()
+{
+#if defined(TB6612FNG_BENCHMARK)
+    if (halBenchmark.fakeClock)
+        return halBenchmark.clock / 1000;
+#endif
+    return millis();
+}
+
+/**
+ * Returns the number of microseconds since the board started
+ * @returns {unsigned long} Elapsed microseconds
+ */
+inline unsigned long halMicros()
+{
+#if defined(TB6612FNG_BENCHMARK)
+    if (halBenchmark.fakeClock)
+        return halBenchmark.clock;
+#endif
+    return micros();
+}
+
+/**
+ * Sets the value of a digital output
+ * @param {pin_size_t} pin - Arduino digital output
+ * @param {bool} high - True to set the output high, else false
+ */
+inline void halDigitalWrite(pin_size_t pin, bool high)
+{
+#if defined(TB6612FNG_BENCHMARK)
+    if (halFakeWrite(pin, high))
+        return;
+#endif
+    digitalWrite(pin, high ? HIGH : LOW);
+}
+
+/**
+ * Reads the value of a digital output
+ * @param {pin_size_t} pin - Arduino digital output
+ * @returns {bool} True if the output is high, else false
+ */
+inline bool halDigitalRead(pin_size_t pin)
+{
+#if defined(TB6612FNG_BENCHMARK)
+    if (halBenchmark.fakePins)
+        return pin < TB6612FNG_BENCHMARK_PINS && halBenchmark.pins[pin];
+#endif
+    return digitalRead(pin) == HIGH;
+}
+
+/**
+ * Reads a byte stored in flash memory (PROGMEM)
+ * @param {const uint8_t*} address - Flash memory address
+ * @returns {uint8_t} Read byte
+ */
+inline uint8_t halReadFlashByte(const uint8_t *address)
+{
+    return pgm_read_byte(address);
+}
+
+/**
+ * Reads a 16-bit word stored in flash memory (PROGMEM)
+ * @param {const uint16_t*} address - Flash memory address
+ * @returns {uint16_t} Read word
+ */
+inline uint16_t halReadFlashWord(const uint16_t *address)
+{
+    return pgm_read_word(address);
+}
+
+#if !defined(TB6612FNG_BENCHMARK) && !defined(TB6612FNG_PORTABLE_GPIO) && (defined(__AVR__) || defined(ARDUINO_ARCH_SAMD))
+// Digital outputs are written through their port registers
+#define HAL_PORT_OUTPUTS
+
+#if defined(__AVR__)
+typedef uint8_t HalPortRegister;
+#else
+typedef uint32_t HalPortRegister;
+#endif
+
+/**
+ * Digital output resolved to its port output register
+ * @typedef {struct} HalOutput
+ * @property {volatile HalPortRegister*} port - Port output register
+ * @property {HalPortRegister} mask - Bit mask of the output in the port register
+ */
+struct HalOutput
+{
+    volatile HalPortRegister *port;
+    HalPortRegister mask;
+};
+
+/**
+ * Resolves the port output register and bit mask of a digital output
+ * @param {pin_size_t} pin - Arduino digital output
+ * @param {HalOutput*} output - Resolved output
+ */
+inline void halResolveOutput(pin_size_t pin, HalOutput *output)
+{
+    output->port = portOutputRegister(digitalPinToPort(pin));
+    output->mask = digitalPinToBitMask(pin);
+}
+
+/**
+ * Sets several outputs of a port with a single port register write
+ * @param {volatile HalPortRegister*} port - Port output register
+ * @param {HalPortRegister} mask - Bit mask of the written outputs
+ * @param {HalPortRegister} value - Bit values of the written outputs
+ * @note The read-modify-write is done with interrupts disabled, so it's atomic
+ */
+inline void halWritePort(volatile HalPortRegister *port, HalPortRegister mask, HalPortRegister value)
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    *port = (*port & ~mask) | (value & mask);
+    halRestoreInterrupts(interruptState);
+}
+#endif
+
+/**
+ * Sets the PWM duty cycle of an output
+ * @param {pin_size_t} pin - Arduino output with PWM feature
+ * @param {uint16_t} value - Duty cycle value
+ */
+inline void halAnalogWrite(pin_size_t pin, uint16_t value)
+{
+#if defined(TB6612FNG_BENCHMARK)
+    if (halFakeWrite(pin, value))
+        return;
+#endif
+    analogWrite(pin, value);
+}
+
+#endif
@@ -4,7 +4,6 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include "Motor.h"
-#include <math.h>
 
 // Public functions
 
@@ -25,8 +24,16 @@ Motor::Motor(PinMap *pinMap)
     pinMode(pinMap_.in2, OUTPUT);
     pinMode(pinMap_.pwm, OUTPUT);
 
-    // Initialize the TurboPWM
-    samd21PWM_ = NULL;
+#if defined(HAL_PORT_OUTPUTS)
+    // Resolve the direction outputs once, so they are written without pin lookups
+    halResolveOutput(pinMap_.in1, &in1Output_);
+    halResolveOutput(pinMap_.in2, &in2Output_);
+#endif
+
+    setPWMBackend_(NULL);
+
+    // The outputs state is unknown until the first operation
+    invalidate();
 }
 
 #if defined(__SAMD21G18A__)
@@ -40,11 +47,40 @@ Motor::Motor(PinMap *pinMap)
  */
 Motor::Motor(PinMap *pinMap, uint32_t customPWMFrequency) : Motor(pinMap)
 {
-    // Get a SAMD21 PWM manager
-    samd21PWM_ = getSAMD21PWMManager_(customPWMFrequency, pinMap->pwm);
+    // Generate the PWM input with the timer of the pin, shared with the motors
+    // whose PWM pins belong to the same timer, or with analogWrite if the pin or the frequency
+    // are not supported, or if the timer already runs at another frequency (see pwmBackend())
+    setPWMBackend_(SAMD21TimerPWM::attach(pinMap->pwm, customPWMFrequency));
+}
+#elif defined(AVR_TIMER_PWM)
+/**
+ * Creates a motor controlled by a TB6612FNG driver
+ * and operated with a custom PWM frequency (AVR processors)
+ * @constructor
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * @param {uint32_t} customPWMFrequency - Custom PWM frequency, in Hertzs
+ * @note The mapped Arduino pins will be initialized by this function
+ */
+Motor::Motor(PinMap *pinMap, uint32_t customPWMFrequency) : Motor(pinMap)
+{
+    // Generate the PWM input with a 16-bit timer, or with analogWrite
+    // if the pin or the frequency are not supported by any timer
+    setPWMBackend_(AVRTimerPWM::attach(pinMap->pwm, customPWMFrequency));
 }
 #endif
 
+/**
+ * Creates a motor controlled by a TB6612FNG driver whose PWM input is generated by a PWM backend
+ * @constructor
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * @param {PWMBackend*} pwmBackend - Backend generating the PWM signal of the mapped PWM pin
+ * @note The mapped Arduino pins will be initialized by this function
+ */
+Motor::Motor(PinMap *pinMap, PWMBackend *pwmBackend) : Motor(pinMap)
+{
+    setPWMBackend_(pwmBackend);
+}
+
 /**
  * Runs the motor in a given direction at a given speed
  * @param {Direction} direction - Motor rotation direction
@@ -52,7 +88,9 @@ Motor::Motor(PinMap *pinMap, uint32_t customPWMFrequency) : Motor(pinMap)
  */
 void Motor::run(Direction direction, uint16_t speed)
 {
-    direction == Direction::Clockwise ? rotateCW_(&pinMap_) : rotateCCW_(&pinMap_);
+    // Direction inputs are only written if the direction or the mode change
+    if (enterRunMode_(direction))
+        direction == Direction::Clockwise ? rotateCW_(&pinMap_) : rotateCCW_(&pinMap_);
     setRotationSpeed_(&pinMap_, speed);
 }
 
@@ -61,7 +99,12 @@ void Motor::run(Direction direction, uint16_t speed)
  */
 void Motor::stop()
 {
+    if (outputMode_ == kStopOutput)
+        return;
+
     stopRotation_(&pinMap_);
+    outputMode_ = kStopOutput;
+    outputDutyValid_ = false;
 }
 
 /**
@@ -69,7 +112,39 @@ void Motor::stop()
  */
 void Motor::brake()
 {
+    if (outputMode_ == kBrakeOutput)
+        return;
+
     brakeRotation_(&pinMap_);
+    outputMode_ = kBrakeOutput;
+    outputDutyValid_ = false;
+}
+
+/**
+ * Forgets the cached state of the motor outputs
+ */
+void Motor::invalidate()
+{
+    outputMode_ = kUnknownOutput;
+    outputDutyValid_ = false;
+}
+
+/**
+ * Returns the resolution of the PWM duty cycle
+ * @returns {uint16_t} Max duty cycle value
+ */
+uint16_t Motor::pwmResolution()
+{
+    return pwmResolution_;
+}
+
+/**
+ * Returns the PWM backend generating the PWM input
+ * @returns {PWMBackend*} PWM backend, or NULL if the PWM input is set by analogWrite
+ */
+PWMBackend *Motor::pwmBackend()
+{
+    return pwmBackend_;
 }
 
 /**
@@ -78,8 +153,7 @@ void Motor::brake()
  */
 void Motor::rotateCW_(PinMap *pinMap)
 {
-    digitalWrite(pinMap->in1, HIGH);
-    digitalWrite(pinMap->in2, LOW);
+    setInputs_(pinMap, true, false);
 }
 
 /**
@@ -88,8 +162,47 @@ void Motor::rotateCW_(PinMap *pinMap)
  */
 void Motor::rotateCCW_(PinMap *pinMap)
 {
-    digitalWrite(pinMap->in1, LOW);
-    digitalWrite(pinMap->in2, HIGH);
+    setInputs_(pinMap, false, true);
+}
+
+/**
+ * Sets the driver IN1 and IN2 inputs
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * @param {bool} in1High - True to set IN1 high, else false
+ * @param {bool} in2High - True to set IN2 high, else false
+ * @note If both inputs share a port, they are set at once. Else the input set low is written first,
+ *  so the driver goes through the stop state (instead of the short brake state) between both writes
+ */
+void Motor::setInputs_(PinMap *pinMap, bool in1High, bool in2High)
+{
+#if defined(HAL_PORT_OUTPUTS)
+    if (in1Output_.port == in2Output_.port)
+    {
+        halWritePort(in1Output_.port, in1Output_.mask | in2Output_.mask,
+                     (in1High ? in1Output_.mask : 0) | (in2High ? in2Output_.mask : 0));
+    }
+    else if (in1High)
+    {
+        halWritePort(in2Output_.port, in2Output_.mask, in2High ? in2Output_.mask : 0);
+        halWritePort(in1Output_.port, in1Output_.mask, in1Output_.mask);
+    }
+    else
+    {
+        halWritePort(in1Output_.port, in1Output_.mask, 0);
+        halWritePort(in2Output_.port, in2Output_.mask, in2High ? in2Output_.mask : 0);
+    }
+#else
+    if (in1High)
+    {
+        halDigitalWrite(pinMap->in2, in2High);
+        halDigitalWrite(pinMap->in1, true);
+    }
+    else
+    {
+        halDigitalWrite(pinMap->in1, false);
+        halDigitalWrite(pinMap->in2, in2High);
+    }
+#endif
 }
 
 /**
@@ -102,137 +215,104 @@ void Motor::setRotationSpeed_(PinMap *pinMap, uint16_t speed)
     // If the speed value is in range, set it as PWM duty cycle
     // Zero value is equivalent to performing a braking, so that
     // value is not acceptable in this function
-    if (speed > 0)
-    {
-#if defined(__SAMD21G18A__)
-        // Set speed
-        if (samd21PWM_)
-            samd21PWM_->analogWrite(pinMap->pwm, scaleSpeed_(speed, 1000));
-        else
-            analogWrite(pinMap->pwm, scaleSpeed_(speed, 255));
-#else
-        analogWrite(pinMap->pwm, scaleSpeed_(speed, 255));
-#endif
-    }
+    uint16_t duty;
+    if (speed > 0 && scaleDuty_(speed, &duty))
+        writePWM_(pinMap, duty);
 }
 
 /**
- * Sets the motor in a idle state
- * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * Sets the run mode and direction as the cached state of the outputs
+ * @param {Direction} direction - Motor rotation direction
+ * @returns {bool} True if the direction inputs must be written, false if they already are in that state
  */
-void Motor::stopRotation_(PinMap *pinMap)
+bool Motor::enterRunMode_(Direction direction)
 {
-    digitalWrite(pinMap->in1, LOW);
-    digitalWrite(pinMap->in2, LOW);
-    analogWrite(pinMap->pwm, 255);
+    if (outputMode_ == kRunOutput && outputDirection_ == direction)
+        return false;
+
+    outputMode_ = kRunOutput;
+    outputDirection_ = direction;
+    return true;
 }
 
 /**
- * Brakes the motor
- * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * Scales a speed to its PWM duty cycle and sets it as the cached duty cycle
+ * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+ * @param {uint16_t*} duty - Duty cycle to write
+ * @returns {bool} True if the duty cycle must be written, false if it equals the lastest written
  */
-void Motor::brakeRotation_(PinMap *pinMap)
+bool Motor::scaleDuty_(uint16_t speed, uint16_t *duty)
 {
-    analogWrite(pinMap->pwm, 0);
-    digitalWrite(pinMap->in1, HIGH);
-    digitalWrite(pinMap->in2, HIGH);
+    // Same speed than the lastest set: The duty cycle doesn't change
+    if (outputDutyValid_ && speed == outputSpeed_)
+        return false;
+
+    // Slow speed changes don't change the duty cycle on every call
+    *duty = scaleSpeed_(speed);
+    outputSpeed_ = speed;
+    if (outputDutyValid_ && *duty == outputDuty_)
+        return false;
+
+    outputDuty_ = *duty;
+    outputDutyValid_ = true;
+    return true;
 }
 
 /**
- * Scales a 16-bit speed value
- * @param {uint16_t} speed - Speed to scale
- * @param {uint16_t} maxScaleValue - Max scale value
- * @returns {uint16_t} Scaled speed value
+ * Sets the motor in a idle state
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
  */
-uint16_t Motor::scaleSpeed_(uint16_t speed, uint16_t maxScaleValue)
+void Motor::stopRotation_(PinMap *pinMap)
 {
-    return round(speed * (maxScaleValue / 65535.0));
+    setInputs_(pinMap, false, false);
+    writePWM_(pinMap, pwmResolution_);
 }
 
-#if defined(__SAMD21G18A__)
-
 /**
- * States if a SAMD21 custom PWM frequency is in the range managed by the library
- * @param {uint32_t} frequency - Custom frequency value
- * @returns True if the custom frequency is a valid value
+ * Brakes the motor
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
  */
-bool Motor::pwmFrequencyInRange_(uint32_t frequency)
+void Motor::brakeRotation_(PinMap *pinMap)
 {
-    // Custom frequency ranges from 732Hz to 100kHz
-    return (frequency >= 732 && frequency <= 100000);
+    writePWM_(pinMap, 0);
+    setInputs_(pinMap, true, true);
 }
 
 /**
- * Returns the SAMD21 timer associated to a given PWM pin
- * @param {pin_size_t} pwmPin - PWM pin
- * @returns {uint8_t} Associated timer (0, 1 or 2) or -1 if the pin is not a PWM timer associated pin
+ * Writes the PWM duty cycle through the PWM backend, if any, or else through analogWrite
+ * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+ * @param {uint16_t} duty - Duty cycle, from 0 to the PWM resolution
  */
-uint8_t Motor::getSAMD21Timer_(pin_size_t pwmPin)
+void Motor::writePWM_(PinMap *pinMap, uint16_t duty)
 {
-    if (pwmPin != 0)
+    if (pwmBackend_)
     {
-        for (int timer = 0; timer < 3; timer++)
-        {
-            for (int pin = 0; pin < 4; pin++)
-            {
-                if (kSam32TimerPinMap[timer][pin] == pwmPin)
-                    return timer;
-            }
-        }
+        HAL_COUNT_PIN_WRITE();
+        pwmBackend_->write(pinMap->pwm, duty);
+        return;
     }
-
-    return -1;
+    halAnalogWrite(pinMap->pwm, duty);
 }
 
 /**
- * Returns the optimal SAMD21 PER register value for a custom PWM frequency
- * @param {uint32_t} frequency - Custom PWM frequency
- * @returns {uint16_t} SAMD21 PER register that allows getting the closest frequency to that set as parameter
+ * Sets the PWM backend and the duty cycle resolution the speeds are scaled to
+ * @param {PWMBackend*} pwmBackend - Backend generating the PWM input, or NULL if it's set by analogWrite
  */
-uint16_t Motor::getSAMD21PER_(uint32_t frequency)
+void Motor::setPWMBackend_(PWMBackend *pwmBackend)
 {
-    // Calculate the PER value together with its ceil and floor values
-    float PER = 24000000.0 / frequency;
-    uint16_t PERCeil = ceil(PER);
-    uint16_t PERFloor = floor(PER);
-
-    // If PER ceil and floor matches, that's the optimal PER value
-    if (PERCeil == PERFloor)
-        return PERCeil;
-
-    // If ceil and floor don't match, the optimal PER value
-    // is that giving the closest frequency to the desired frequency
-    float ceilFrequency = 24000000.0 / PERCeil;
-    float floorFrequency = 24000000.0 / PERFloor;
-    if (abs(frequency - ceilFrequency) < abs(frequency - floorFrequency))
-        return PERCeil;
-    return PERFloor;
+    pwmBackend_ = pwmBackend;
+    pwmResolution_ = pwmBackend ? pwmBackend->resolution() : 255;
 }
 
 /**
- * Initializes a SAMD21 TurboPWM custom PWM manager object instance
- * @param {uint32_t} frequency - Custom PWM frequency
- * @param {pin_size_t} pwmPin - Pin used as PWM signal output
- * @returns Pointer to a TurboPWM object instance, or NULL if error
+ * Scales a 16-bit speed value to the PWM duty cycle resolution
+ * @param {uint16_t} speed - Speed to scale
+ * @returns {uint16_t} Duty cycle, equal to round(speed * pwmResolution_ / 65535) computed in integer math
  */
-TurboPWM *Motor::getSAMD21PWMManager_(uint32_t frequency, pin_size_t pwmPin)
+uint16_t Motor::scaleSpeed_(uint16_t speed)
 {
-    int timer;
-    if (!pwmFrequencyInRange_(frequency) || (timer = getSAMD21Timer_(pwmPin)) < 0)
-        // Frequency out of range or PWM pin not associated to timer
-        return NULL;
-
-    TurboPWM *turboPWM = new TurboPWM();
-
-    // Configure a timer with source frequency 48Mhz...
-    turboPWM->setClockDivider(1, false);
-    // ...using the timer defined by the chosen PWM output pin,
-    // with prescaler set to constant 1
-    // and PER calculated from the desired PWM frequency
-    // generating a double-slope PWM signal
-    uint16_t PER = getSAMD21PER_(frequency);
-    turboPWM->timer(timer, 1, PER, false);
-
-    return turboPWM;
+    // The rounded product is divided by 65535 (2^16 - 1) adding its high half before shifting it,
+    // what is exact for dividends below 65535 * 65536
+    uint32_t product = (uint32_t)speed * pwmResolution_ + 32767;
+    return (product + (product >> 16) + 1) >> 16;
 }
-#endif
\ No newline at end of file
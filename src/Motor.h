@@ -6,23 +6,9 @@
 #ifndef MOTOR_H
 #define MOTOR_H
 
-#include <Arduino.h>
-#if defined(__SAMD21G18A__)
-#include <SAMD21turboPWM.h>
-#endif
-
-#if defined(__SAMD21G18A__)
-#if defined(ARDUINO_SAMD_NANO_33_IOT)
-// PWM pins associated to each timer in a Arduino SAMD Nano 33
-const uint8_t kSam32TimerPinMap[3][4] = {{5, 6, 8, 12}, {4, 7, 0, 0}, {11, 13, 0, 0}};
-#elif defined(ARDUINO_SAMD_ZERO)
-// PWM pins associated to each timer in a Arduino SAMD Zero
-const uint8_t kSam32TimerPinMap[3][4] = {{3, 4, 10, 12}, {8, 9, 0, 0}, {11, 13, 0, 0}};
-#else
-// PWM pins associated to each timer in a Arduino SAMD MKR series
-const uint8_t kSam32TimerPinMap[3][4] = {{4, 5, 6, 7}, {2, 3, 0, 0}, {8, 9, 0, 0}};
-#endif
-#endif
+#include "Hal.h"
+#include "AVRTimerPWM.h"
+#include "SAMD21TimerPWM.h"
 
 /**
  * Rotation directions
@@ -64,11 +50,37 @@ typedef struct
 // } SAMD21CustomPWM;
 // #endif
 
+/**
+ * Operations shared by every motor controlled by a TB6612FNG driver
+ * @class
+ * @abstract
+ */
+class MotorInterface
+{
+public:
+    /**
+     * Runs the motor in a given direction at a given speed
+     * @param {Direction} direction - Motor rotation direction
+     * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+     */
+    virtual void run(Direction direction, uint16_t speed) = 0;
+
+    /**
+     * Stops the motor
+     */
+    virtual void stop() = 0;
+
+    /**
+     * Short-brakes the motor
+     */
+    virtual void brake() = 0;
+};
+
 /**
  * Represents a motor controlled by a TB6612FNG driver
  * @class
  */
-class Motor
+class Motor : public MotorInterface
 {
 public:
     /**
@@ -79,10 +91,10 @@ public:
      */
     Motor(PinMap *pinMap);
 
-#if defined(__SAMD21G18A__)
+#if defined(__SAMD21G18A__) || defined(AVR_TIMER_PWM)
     /**
      * Creates a motor controlled by a TB6612FNG driver 
-     * and operated with a custom PWM frequency (SAMD21 processors)
+     * and operated with a custom PWM frequency (SAMD21 processors, and AVR processors through their 16-bit timers)
      * @constructor
      * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
      * @param {uint32_t} customPWMFrequency - Custom PWM frequency, in Hertzs
@@ -91,44 +103,99 @@ public:
     Motor(PinMap *pinMap, uint32_t customPWMFrequency);
 #endif
 
+    /**
+     * Creates a motor controlled by a TB6612FNG driver whose PWM input is generated by a PWM backend
+     * @constructor
+     * @param {PinMap*} pinMap - Mapping of motor inputs and Arduino pins
+     * @param {PWMBackend*} pwmBackend - Backend generating the PWM signal of the mapped PWM pin
+     * @note The mapped Arduino pins will be initialized by this function
+     */
+    Motor(PinMap *pinMap, PWMBackend *pwmBackend);
+
     /**
      * Runs the motor in a given direction at a given speed
      * @param {Direction} direction - Motor rotation direction
      * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
      * @note Spinning will be aborted if this function is invoked
      */
-    void run(Direction direction, uint16_t speed);
+    void run(Direction direction, uint16_t speed) override;
 
     /**
      * Stops the motor
      * @note Spinning will be aborted if this function is invoked
      */
-    void stop();
+    void stop() override;
 
     /**
      * Short-brakes the motor
      * @note Spinning will be aborted if this function is invoked
      */
-    void brake();
+    void brake() override;
+
+    /**
+     * Forgets the cached state of the motor outputs, so that all of them are written by the next operation
+     * @note The motor only writes the outputs whose value changes. This function must be invoked
+     *  after manipulating the mapped Arduino pins out of this class
+     */
+    void invalidate();
+
+    /**
+     * Returns the resolution of the PWM duty cycle
+     * @returns {uint16_t} Max duty cycle value, the motor speeds being scaled from 65535 to it
+     */
+    uint16_t pwmResolution();
+
+    /**
+     * Returns the PWM backend generating the PWM input
+     * @returns {PWMBackend*} PWM backend, or NULL if the PWM input is set by analogWrite at the standard PWM frequency
+     * @note A motor created with a custom PWM frequency falls back to analogWrite if the frequency can't be generated,
+     *  so this function tells whether the custom frequency was set
+     */
+    PWMBackend *pwmBackend();
 
 private:
+    friend class Driver;
+
+    // Motor outputs state, as set by the last operation
+    enum OutputMode
+    {
+        kUnknownOutput,
+        kRunOutput,
+        kStopOutput,
+        kBrakeOutput
+    };
+
     PinMap pinMap_;
-    bool customPWM_ = false;
+
+    // Cached state of the outputs: mode, direction and PWM duty cycle,
+    // together with the speed the duty cycle was scaled from
+    OutputMode outputMode_;
+    Direction outputDirection_;
+    bool outputDutyValid_;
+    uint16_t outputSpeed_;
+    uint16_t outputDuty_;
+
+    // PWM backend generating the PWM input, or NULL if it's set by analogWrite,
+    // and its duty cycle resolution, read once when the backend is set
+    PWMBackend *pwmBackend_;
+    uint16_t pwmResolution_;
+
+#if defined(HAL_PORT_OUTPUTS)
+    // IN1 and IN2 outputs, resolved to their port registers by the constructor
+    HalOutput in1Output_, in2Output_;
+#endif
 
     void rotateCW_(PinMap *pinMap);
     void rotateCCW_(PinMap *pinMap);
+    void setInputs_(PinMap *pinMap, bool in1High, bool in2High);
     void setRotationSpeed_(PinMap *pinMap, uint16_t speed);
+    bool enterRunMode_(Direction direction);
+    bool scaleDuty_(uint16_t speed, uint16_t *duty);
     void stopRotation_(PinMap *pinMap);
     void brakeRotation_(PinMap *pinMap);
-    uint16_t scaleSpeed_(uint16_t speed, uint16_t maxScaleValue);
-
-#if defined(__SAMD21G18A__)
-    TurboPWM *samd21PWM_;
-    bool pwmFrequencyInRange_(uint32_t frequency);
-    TurboPWM *getSAMD21PWMManager_(uint32_t frequency, pin_size_t pwmPin);
-    uint8_t getSAMD21Timer_(pin_size_t pwmPin);
-    uint16_t getSAMD21PER_(uint32_t frequency);
-#endif
+    void writePWM_(PinMap *pinMap, uint16_t duty);
+    void setPWMBackend_(PWMBackend *pwmBackend);
+    uint16_t scaleSpeed_(uint16_t speed);
 };
 
 #endif
\ No newline at end of file
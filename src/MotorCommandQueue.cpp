@@ -0,0 +1,232 @@
+// MotorCommandQueue.cpp
+// Implementation of the MotorCommandQueue class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "MotorCommandQueue.h"
+
+// Public functions definition
+
+/**
+ * Creates a command queue for a motor using a milliseconds timebase
+ * @constructor
+ * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+ * @param {MotorCommand[]} buffer - Ring buffer storing the queued commands
+ * @param {uint8_t} bufferSize - Number of commands of the buffer
+ */
+MotorCommandQueue::MotorCommandQueue(MotorInterface *motor, MotorCommand buffer[], uint8_t bufferSize) : MotorCommandQueue(motor, buffer, bufferSize, Milliseconds){};
+
+/**
+ * Creates a command queue for a motor using a given timebase
+ * @constructor
+ * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+ * @param {MotorCommand[]} buffer - Ring buffer storing the queued commands
+ * @param {uint8_t} bufferSize - Number of commands of the buffer
+ * @param {SpinTimebase} timebase - Timebase of the command times
+ */
+MotorCommandQueue::MotorCommandQueue(MotorInterface *motor, MotorCommand buffer[], uint8_t bufferSize, SpinTimebase timebase) : motor_(motor), buffer_(buffer), bufferSize_(bufferSize), timebase_(timebase)
+{
+    head_ = tail_ = 0;
+    lastTime_ = 0;
+}
+
+/**
+ * Queues a run command executed a given time after the previous command
+ * @param {Direction} direction - Motor rotation direction
+ * @param {uint16_t} speed - Motor rotation speed
+ * @param {unsigned long} delay - Timebase ticks from the execution of the previous command
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::run(Direction direction, uint16_t speed, unsigned long delay)
+{
+    return queue_(kRunAction, direction, speed, delay, true);
+}
+
+/**
+ * Queues a stop command executed a given time after the previous command
+ * @param {unsigned long} delay - Timebase ticks from the execution of the previous command
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::stop(unsigned long delay)
+{
+    return queue_(kStopAction, Clockwise, 0, delay, true);
+}
+
+/**
+ * Queues a short brake command executed a given time after the previous command
+ * @param {unsigned long} delay - Timebase ticks from the execution of the previous command
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::brake(unsigned long delay)
+{
+    return queue_(kBrakeAction, Clockwise, 0, delay, true);
+}
+
+/**
+ * Queues a run command executed at a given time
+ * @param {Direction} direction - Motor rotation direction
+ * @param {uint16_t} speed - Motor rotation speed
+ * @param {unsigned long} time - Execution time, in timebase ticks
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::runAt(Direction direction, uint16_t speed, unsigned long time)
+{
+    return queue_(kRunAction, direction, speed, time, false);
+}
+
+/**
+ * Queues a stop command executed at a given time
+ * @param {unsigned long} time - Execution time, in timebase ticks
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::stopAt(unsigned long time)
+{
+    return queue_(kStopAction, Clockwise, 0, time, false);
+}
+
+/**
+ * Queues a short brake command executed at a given time
+ * @param {unsigned long} time - Execution time, in timebase ticks
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::brakeAt(unsigned long time)
+{
+    return queue_(kBrakeAction, Clockwise, 0, time, false);
+}
+
+/**
+ * Executes the queued commands whose time was reached
+ * @returns {bool} True if any command is still queued, else false
+ */
+bool MotorCommandQueue::update()
+{
+    return update(getTime_());
+}
+
+/**
+ * Executes the queued commands whose time was reached at a given time
+ * @param {unsigned long} time - Current time in timebase ticks
+ * @returns {bool} True if any command is still queued, else false
+ */
+bool MotorCommandQueue::update(unsigned long time)
+{
+    uint8_t tail = tail_;
+    while (tail != head_)
+    {
+        // Signed difference keeps the comparison right when the Arduino time counter overflows
+        MotorCommand *command = &buffer_[tail];
+        if ((long)(time - command->time) < 0)
+            return true;
+
+        if (command->action == kRunAction && command->speed > 0)
+            motor_->run((Direction)command->direction, command->speed);
+        else if (command->action == kBrakeAction)
+            motor_->brake();
+        else
+            motor_->stop();
+
+        // Release the command slot to the producer once it's executed
+        halCompilerBarrier();
+        tail = tail + 1 == bufferSize_ ? 0 : tail + 1;
+        tail_ = tail;
+    }
+
+    return false;
+}
+
+/**
+ * Gets the execution time of the next queued command
+ * @param {unsigned long*} dueTime - Due time in timebase ticks
+ * @returns {bool} True if the due time was got, false if the queue is empty
+ */
+bool MotorCommandQueue::nextUpdateDue(unsigned long *dueTime)
+{
+    uint8_t tail = tail_;
+    if (tail == head_)
+        return false;
+
+    *dueTime = buffer_[tail].time;
+    return true;
+}
+
+/**
+ * Drops every queued command
+ */
+void MotorCommandQueue::clear()
+{
+    // The tail is owned by update(), that may be called from an interrupt
+    HalInterruptState interruptState = halDisableInterrupts();
+    tail_ = head_;
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Returns the number of queued commands
+ * @returns {uint8_t} Commands queued and not yet executed
+ */
+uint8_t MotorCommandQueue::available()
+{
+    uint8_t head = head_;
+    uint8_t tail = tail_;
+    return head >= tail ? head - tail : bufferSize_ - tail + head;
+}
+
+/**
+ * Returns the number of commands that can be queued
+ * @returns {uint8_t} Free buffer commands
+ */
+uint8_t MotorCommandQueue::space()
+{
+    return bufferSize_ - 1 - available();
+}
+
+// Private functions definition
+
+/**
+ * Gets the current time in timebase ticks
+ * @returns {unsigned long} Current time, in milliseconds or microseconds depending on the timebase
+ */
+unsigned long MotorCommandQueue::getTime_()
+{
+    return timebase_ == Milliseconds ? halMillis() : halMicros();
+}
+
+/**
+ * Queues a command
+ * @param {Action} action - Motor operation
+ * @param {Direction} direction - Motor rotation direction of a run command
+ * @param {uint16_t} speed - Motor rotation speed of a run command
+ * @param {unsigned long} time - Execution time, or delay from the previous command if relative
+ * @param {bool} relative - True if the time is a delay from the previous command, false if it's absolute
+ * @returns {bool} True if the command was queued, false if the queue is full
+ */
+bool MotorCommandQueue::queue_(Action action, Direction direction, uint16_t speed, unsigned long time, bool relative)
+{
+    // A slot is always left empty, telling a full buffer from an empty one
+    uint8_t head = head_;
+    uint8_t nextHead = head + 1 == bufferSize_ ? 0 : head + 1;
+    if (nextHead == tail_)
+        return false;
+
+    if (relative)
+    {
+        // Delays are chained from the previous command time, so a sequence doesn't drift
+        // with the update latency. An idle queue chains them from now, even if its last command
+        // was dropped by clear() before its time
+        if (head == tail_)
+            lastTime_ = getTime_();
+        time += lastTime_;
+    }
+    lastTime_ = time;
+
+    MotorCommand *command = &buffer_[head];
+    command->time = time;
+    command->speed = speed;
+    command->action = action;
+    command->direction = direction;
+
+    // Publish the command once it's fully written
+    halCompilerBarrier();
+    head_ = nextHead;
+    return true;
+}
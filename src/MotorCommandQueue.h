@@ -0,0 +1,169 @@
+// MotorCommandQueue.h
+// Header file for MotorCommandQueue class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef MOTOR_COMMAND_QUEUE_H
+#define MOTOR_COMMAND_QUEUE_H
+
+#include "Spinner.h"
+
+/**
+ * Motor command stored by a command queue
+ * @typedef {struct} MotorCommand
+ * @property {unsigned long} time - Execution time, in timebase ticks
+ * @property {uint16_t} speed - Rotation speed of a run command
+ * @property {uint8_t} action - Motor operation: run, stop or brake
+ * @property {int8_t} direction - Rotation direction of a run command
+ * @note Command queue buffers are declared as arrays of this struct, whose fields are set by the queue
+ */
+struct MotorCommand
+{
+    unsigned long time;
+    uint16_t speed;
+    uint8_t action;
+    int8_t direction;
+};
+
+/**
+ * Queue of motor operations executed at given times, without blocking the program
+ * @class
+ * @note Commands are stored in a ring buffer and executed in the order they were queued
+ */
+class MotorCommandQueue
+{
+public:
+    /**
+     * Creates a command queue for a motor using a milliseconds timebase
+     * @constructor
+     * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+     * @param {MotorCommand[]} buffer - Ring buffer storing the queued commands
+     * @param {uint8_t} bufferSize - Number of commands of the buffer, from 2 to 255. The queue holds up to bufferSize - 1 commands
+     */
+    MotorCommandQueue(MotorInterface *motor, MotorCommand buffer[], uint8_t bufferSize);
+
+    /**
+     * Creates a command queue for a motor using a given timebase
+     * @constructor
+     * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+     * @param {MotorCommand[]} buffer - Ring buffer storing the queued commands
+     * @param {uint8_t} bufferSize - Number of commands of the buffer, from 2 to 255. The queue holds up to bufferSize - 1 commands
+     * @param {SpinTimebase} timebase - Timebase of the command times
+     */
+    MotorCommandQueue(MotorInterface *motor, MotorCommand buffer[], uint8_t bufferSize, SpinTimebase timebase);
+
+    /**
+     * Queues a run command executed a given time after the previous command
+     * @param {Direction} direction - Motor rotation direction
+     * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+     * @param {unsigned long} delay - Timebase ticks from the execution of the previous command, or from now if the queue is idle
+     * @returns {bool} True if the command was queued, false if the queue is full
+     */
+    bool run(Direction direction, uint16_t speed, unsigned long delay);
+
+    /**
+     * Queues a stop command executed a given time after the previous command
+     * @param {unsigned long} delay - Timebase ticks from the execution of the previous command, or from now if the queue is idle
+     * @returns {bool} True if the command was queued, false if the queue is full
+     */
+    bool stop(unsigned long delay);
+
+    /**
+     * Queues a short brake command executed a given time after the previous command
+     * @param {unsigned long} delay - Timebase ticks from the execution of the previous command, or from now if the queue is idle
+     * @returns {bool} True if the command was queued, false if the queue is full
+     */
+    bool brake(unsigned long delay);
+
+    /**
+     * Queues a run command executed at a given time
+     * @param {Direction} direction - Motor rotation direction
+     * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+     * @param {unsigned long} time - Execution time, in timebase ticks, as returned by millis() or micros()
+     * @returns {bool} True if the command was queued, false if the queue is full
+     * @note A command is never executed before the previous commands
+     */
+    bool runAt(Direction direction, uint16_t speed, unsigned long time);
+
+    /**
+     * Queues a stop command executed at a given time
+     * @param {unsigned long} time - Execution time, in timebase ticks, as returned by millis() or micros()
+     * @returns {bool} True if the command was queued, false if the queue is full
+     * @note A command is never executed before the previous commands
+     */
+    bool stopAt(unsigned long time);
+
+    /**
+     * Queues a short brake command executed at a given time
+     * @param {unsigned long} time - Execution time, in timebase ticks, as returned by millis() or micros()
+     * @returns {bool} True if the command was queued, false if the queue is full
+     * @note A command is never executed before the previous commands
+     */
+    bool brakeAt(unsigned long time);
+
+    /**
+     * Executes the queued commands whose time was reached
+     * @returns {bool} True if any command is still queued, else false
+     * @note This function must be called periodically, as Spinner.spin()
+     */
+    bool update();
+
+    /**
+     * Executes the queued commands whose time was reached at a given time
+     * @param {unsigned long} time - Current time in timebase ticks, as returned by millis() or micros()
+     * @returns {bool} True if any command is still queued, else false
+     * @note Allows updating the queue and several spinners with a single clock read, for instance from a timer interrupt
+     */
+    bool update(unsigned long time);
+
+    /**
+     * Gets the execution time of the next queued command
+     * @param {unsigned long*} dueTime - Due time in timebase ticks, as returned by millis() or micros()
+     * @returns {bool} True if the due time was got, false if the queue is empty
+     */
+    bool nextUpdateDue(unsigned long *dueTime);
+
+    /**
+     * Drops every queued command
+     */
+    void clear();
+
+    /**
+     * Returns the number of queued commands
+     * @returns {uint8_t} Commands queued and not yet executed
+     */
+    uint8_t available();
+
+    /**
+     * Returns the number of commands that can be queued
+     * @returns {uint8_t} Free buffer commands
+     */
+    uint8_t space();
+
+private:
+    // Motor operations
+    enum Action
+    {
+        kRunAction,
+        kStopAction,
+        kBrakeAction
+    };
+
+    MotorInterface *motor_;
+    MotorCommand *buffer_;
+    uint8_t bufferSize_;
+    SpinTimebase timebase_;
+
+    // Single producer, single consumer ring: the head is only moved by the queueing functions
+    // and the tail by update(), so no critical section is needed
+    volatile uint8_t head_;
+    volatile uint8_t tail_;
+
+    // Execution time of the last queued command, the reference of the next relative command
+    unsigned long lastTime_;
+
+    unsigned long getTime_();
+    bool queue_(Action, Direction, uint16_t, unsigned long, bool);
+};
+
+#endif
@@ -0,0 +1,35 @@
+// PWMBackend.h
+// Header file for the PWM backend interface used by the Motor class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PWM_BACKEND_H
+#define PWM_BACKEND_H
+
+#include "Hal.h"
+
+/**
+ * Hardware PWM generator setting the duty cycle of the driver PWM inputs
+ * @class
+ * @abstract
+ * @note The duty cycle ranges from 0 (output continuously low) to resolution() (output continuously high),
+ *  so the Motor class scales its speeds to the resolution of its backend
+ */
+class PWMBackend
+{
+public:
+    /**
+     * Returns the duty cycle value setting the output continuously high
+     * @returns {uint16_t} Max duty cycle value
+     */
+    virtual uint16_t resolution() = 0;
+
+    /**
+     * Sets the duty cycle of an output
+     * @param {pin_size_t} pin - Arduino output generated by the backend
+     * @param {uint16_t} duty - Duty cycle, from 0 to resolution()
+     */
+    virtual void write(pin_size_t pin, uint16_t duty) = 0;
+};
+
+#endif
@@ -0,0 +1,138 @@
+// SAMD21TimerPWM.cpp
+// Implementation of the SAMD21TimerPWM class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "SAMD21TimerPWM.h"
+
+#if defined(__SAMD21G18A__)
+
+SAMD21TimerPWM SAMD21TimerPWM::timers_[3];
+
+// Public functions definition
+
+/**
+ * Generates the PWM signal of an output at a given frequency
+ * @param {pin_size_t} pin - Arduino output connected to a TCC timer
+ * @param {uint32_t} frequency - PWM frequency, in Hertzs, from 732 to 100000
+ * @returns {SAMD21TimerPWM*} Backend generating the output, or NULL if error
+ */
+SAMD21TimerPWM *SAMD21TimerPWM::attach(pin_size_t pin, uint32_t frequency)
+{
+    int8_t timerNumber = getTimer_(pin);
+
+    // Custom frequency ranges from 732Hz to 100kHz
+    if (timerNumber < 0 || frequency < 732 || frequency > 100000)
+        return NULL;
+
+    // A timer already set up is shared by all its outputs, so they must use the same frequency
+    SAMD21TimerPWM *timer = &timers_[timerNumber];
+    uint16_t period = getPeriod_(frequency);
+    if (timer->period_ != 0)
+        return timer->period_ == period ? timer : NULL;
+
+    // Configure the timer with prescaler set to constant 1
+    // and PER calculated from the desired PWM frequency
+    // generating a double-slope PWM signal
+    turboPWM_()->timer(timerNumber, 1, period, false);
+    timer->period_ = period;
+
+    return timer;
+}
+
+/**
+ * Returns the PWM frequency generated by the timer
+ * @returns {uint32_t} Frequency, in Hertzs, rounded to the nearest integer, or 0 if the timer is not set up
+ */
+uint32_t SAMD21TimerPWM::frequency()
+{
+    if (period_ == 0)
+        return 0;
+    return (kTimerClock + period_ / 2) / period_;
+}
+
+/**
+ * Returns the duty cycle value setting the output continuously high
+ * @returns {uint16_t} Max duty cycle value
+ */
+uint16_t SAMD21TimerPWM::resolution()
+{
+    return 1000;
+}
+
+/**
+ * Sets the duty cycle of an output
+ * @param {pin_size_t} pin - Arduino output attached to the timer
+ * @param {uint16_t} duty - Duty cycle, from 0 to resolution()
+ */
+void SAMD21TimerPWM::write(pin_size_t pin, uint16_t duty)
+{
+    turboPWM_()->analogWrite(pin, duty);
+}
+
+// Private functions definition
+
+/**
+ * Returns the TurboPWM manager shared by all the timers
+ * @returns {TurboPWM*} TurboPWM manager, created and set up on the first call
+ */
+TurboPWM *SAMD21TimerPWM::turboPWM_()
+{
+    static TurboPWM turboPWM;
+    static bool setUp = false;
+
+    if (!setUp)
+    {
+        // The timers clock source is 48Mhz, shared by all the timers
+        turboPWM.setClockDivider(1, false);
+        setUp = true;
+    }
+    return &turboPWM;
+}
+
+/**
+ * Returns the timer associated to a given PWM pin
+ * @param {pin_size_t} pin - PWM pin
+ * @returns {int8_t} Associated timer (0, 1 or 2) or -1 if the pin is not a PWM timer associated pin
+ */
+int8_t SAMD21TimerPWM::getTimer_(pin_size_t pin)
+{
+    if (pin != 0)
+    {
+        for (int8_t timer = 0; timer < 3; timer++)
+        {
+            for (uint8_t i = 0; i < 4; i++)
+            {
+                if (kSam32TimerPinMap[timer][i] == pin)
+                    return timer;
+            }
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the optimal PER register value for a PWM frequency
+ * @param {uint32_t} frequency - PWM frequency
+ * @returns {uint16_t} PER register that allows getting the closest frequency to that set as parameter
+ */
+uint16_t SAMD21TimerPWM::getPeriod_(uint32_t frequency)
+{
+    // Calculate the PER floor value, together with the division remainder
+    uint16_t periodFloor = kTimerClock / frequency;
+    uint32_t remainder = kTimerClock % frequency;
+
+    // If the division is exact, that's the optimal PER value
+    if (remainder == 0)
+        return periodFloor;
+
+    // Else the optimal PER value is that giving the closest frequency to the desired frequency.
+    // The floor value frequency exceeds it by remainder / floor, and the ceil value frequency
+    // falls short of it by (frequency - remainder) / (floor + 1)
+    if ((frequency - remainder) * periodFloor < remainder * (periodFloor + 1))
+        return periodFloor + 1;
+    return periodFloor;
+}
+
+#endif
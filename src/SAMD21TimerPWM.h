@@ -0,0 +1,79 @@
+// SAMD21TimerPWM.h
+// Header file for SAMD21TimerPWM class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SAMD21_TIMER_PWM_H
+#define SAMD21_TIMER_PWM_H
+
+#include "PWMBackend.h"
+
+#if defined(__SAMD21G18A__)
+#include <SAMD21turboPWM.h>
+
+#if defined(ARDUINO_SAMD_NANO_33_IOT)
+// PWM pins associated to each timer in a Arduino SAMD Nano 33
+const uint8_t kSam32TimerPinMap[3][4] = {{5, 6, 8, 12}, {4, 7, 0, 0}, {11, 13, 0, 0}};
+#elif defined(ARDUINO_SAMD_ZERO)
+// PWM pins associated to each timer in a Arduino SAMD Zero
+const uint8_t kSam32TimerPinMap[3][4] = {{3, 4, 10, 12}, {8, 9, 0, 0}, {11, 13, 0, 0}};
+#else
+// PWM pins associated to each timer in a Arduino SAMD MKR series
+const uint8_t kSam32TimerPinMap[3][4] = {{4, 5, 6, 7}, {2, 3, 0, 0}, {8, 9, 0, 0}};
+#endif
+
+/**
+ * PWM backend generating the driver PWM inputs with the TCC0 to TCC2 timers of the SAMD21 processors
+ * @class
+ * @note The backends of the three timers are allocated statically and share a single TurboPWM manager,
+ *  so every timer is set up once, and all the outputs of a timer share its frequency
+ */
+class SAMD21TimerPWM : public PWMBackend
+{
+public:
+    /**
+     * Generates the PWM signal of an output at a given frequency
+     * @param {pin_size_t} pin - Arduino output connected to a TCC timer (see kSam32TimerPinMap)
+     * @param {uint32_t} frequency - PWM frequency, in Hertzs, from 732 to 100000
+     * @returns {SAMD21TimerPWM*} Backend generating the output, or NULL if the pin is not a timer output,
+     *  the frequency is out of range, or the timer already runs at another frequency
+     */
+    static SAMD21TimerPWM *attach(pin_size_t pin, uint32_t frequency);
+
+    /**
+     * Returns the PWM frequency generated by the timer
+     * @returns {uint32_t} Frequency, in Hertzs, rounded to the nearest integer, or 0 if the timer is not set up
+     */
+    uint32_t frequency();
+
+    /**
+     * Returns the duty cycle value setting the output continuously high
+     * @returns {uint16_t} Max duty cycle value, 1000 as set by TurboPWM
+     */
+    uint16_t resolution() override;
+
+    /**
+     * Sets the duty cycle of an output
+     * @param {pin_size_t} pin - Arduino output attached to the timer
+     * @param {uint16_t} duty - Duty cycle, from 0 to resolution()
+     */
+    void write(pin_size_t pin, uint16_t duty) override;
+
+private:
+    // Timer clock frequency, halved by the double-slope PWM
+    static const uint32_t kTimerClock = 24000000;
+
+    // Period (PER register) the timer was set up with, or 0 if the timer is not set up
+    uint16_t period_;
+
+    static SAMD21TimerPWM timers_[3];
+
+    constexpr SAMD21TimerPWM() : period_(0) {}
+    static TurboPWM *turboPWM_();
+    static int8_t getTimer_(pin_size_t pin);
+    static uint16_t getPeriod_(uint32_t frequency);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+// SpinProfile.cpp
+// Implementation of the SpinProfile class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "SpinProfile.h"
+
+// Public functions definition
+
+/**
+ * Creates a spin profile with linear segments
+ * @constructor
+ * @param {LongSpinPoint[]} points - Profile points
+ * @param {uint8_t} size - Number of points of the profile
+ */
+SpinProfile::SpinProfile(LongSpinPoint points[], uint8_t size) : SpinProfile(points, size, NULL){};
+
+/**
+ * Creates a spin profile and the curves of its segments
+ * @constructor
+ * @param {LongSpinPoint[]} points - Profile points
+ * @param {uint8_t} size - Number of points of the profile
+ * @param {const uint8_t[]} segmentCurves - SpinCurve of every profile segment, or null if all the segments are linear
+ */
+SpinProfile::SpinProfile(LongSpinPoint points[], uint8_t size, const uint8_t segmentCurves[]) : points_(points), size_(size), curves_(segmentCurves)
+{
+    loopIndex_ = 0;
+    loopCount_ = 0;
+}
+
+/**
+ * Sets the profile loop
+ * @param {uint8_t} loopIndex - Index of the point the profile loops back to
+ * @param {uint16_t} loopCount - Times the profile loops back, 0 not to loop, or SPIN_LOOP_FOREVER
+ * @returns {bool} True if the loop was set, false if the loop point is not before the last profile point
+ */
+bool SpinProfile::loop(uint8_t loopIndex, uint16_t loopCount)
+{
+    // A loop must last some time, or the profile would never get past its last point.
+    // The index is checked even if the profile doesn't loop, since it's kept for later loops
+    if (loopIndex >= size_ - 1)
+        return false;
+
+    loopIndex_ = loopIndex;
+    loopCount_ = loopCount;
+    return true;
+}
+
+/**
+ * Returns the number of profile points
+ * @returns {uint8_t} Number of points of the profile
+ */
+uint8_t SpinProfile::size()
+{
+    return size_;
+}
@@ -0,0 +1,79 @@
+// SpinProfile.h
+// Header file for SpinProfile class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SPIN_PROFILE_H
+#define SPIN_PROFILE_H
+
+#include "Spinner.h"
+
+// Loop count of the profiles looping until their spin is aborted
+#define SPIN_LOOP_FOREVER 0xFFFF
+
+/**
+ * Spin profile point, with a 32-bit time
+ * @typedef {struct} LongSpinPoint
+ * @property {uint16_t} speed - Spin speed, from 0 (0%) to 65535 (100%)
+ * @property {uint32_t} time - Elapsed time from the spin start, in milliseconds, in which speed must be reached
+ */
+struct LongSpinPoint
+{
+    uint16_t speed;
+    uint32_t time;
+};
+
+/**
+ * Spin map with 32-bit point times, optionally looping back to one of its points a number of times
+ * @class
+ * @note A looping profile goes on from its loop point once its last point is reached, without
+ *  restarting the spin, so the loop cycles are spun back-to-back however long the spin lasts
+ */
+class SpinProfile
+{
+public:
+    /**
+     * Creates a spin profile with linear segments
+     * @constructor
+     * @param {LongSpinPoint[]} points - Profile points
+     * @param {uint8_t} size - Number of points of the profile
+     */
+    SpinProfile(LongSpinPoint points[], uint8_t size);
+
+    /**
+     * Creates a spin profile and the curves of its segments
+     * @constructor
+     * @param {LongSpinPoint[]} points - Profile points
+     * @param {uint8_t} size - Number of points of the profile
+     * @param {const uint8_t[]} segmentCurves - SpinCurve of every profile segment, ie, size - 1 curves
+     */
+    SpinProfile(LongSpinPoint points[], uint8_t size, const uint8_t segmentCurves[]);
+
+    /**
+     * Sets the profile loop
+     * @param {uint8_t} loopIndex - Index of the point the profile loops back to once its last point is reached, lower than size - 1 even if loopCount is 0
+     * @param {uint16_t} loopCount - Times the profile loops back, 0 (default) not to loop, or SPIN_LOOP_FOREVER
+     * @returns {bool} True if the loop was set, false if the loop point is not before the last profile point
+     * @note The last profile point and the loop point are the same instant of the loop cycle, so the
+     *  speed steps from the last point speed to the loop point speed if they differ
+     * @note The loop applies to the next spin operations started with the profile
+     */
+    bool loop(uint8_t loopIndex, uint16_t loopCount);
+
+    /**
+     * Returns the number of profile points
+     * @returns {uint8_t} Number of points of the profile
+     */
+    uint8_t size();
+
+private:
+    friend class Spinner;
+
+    LongSpinPoint *points_;
+    uint8_t size_;
+    const uint8_t *curves_;
+    uint8_t loopIndex_;
+    uint16_t loopCount_;
+};
+
+#endif
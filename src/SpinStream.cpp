@@ -0,0 +1,150 @@
+// SpinStream.cpp
+// Implementation of the SpinStream class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "SpinStream.h"
+
+// Public functions definition
+
+/**
+ * Creates a spin stream
+ * @constructor
+ * @param {SpinPoint[]} buffer - Ring buffer storing the stream points
+ * @param {uint8_t} bufferSize - Number of spin points of the buffer
+ */
+SpinStream::SpinStream(SpinPoint buffer[], uint8_t bufferSize) : buffer_(buffer), bufferSize_(bufferSize)
+{
+    reset();
+}
+
+/**
+ * Appends a point to the stream
+ * @param {uint16_t} speed - Spin speed
+ * @param {uint16_t} timeIncrement - Time, in milliseconds, to reach the speed since the previous stream point
+ * @returns {bool} True if the point was appended, false if the buffer is full, the stream is closed or the time increment is zero
+ */
+bool SpinStream::append(uint16_t speed, uint16_t timeIncrement)
+{
+    if (closed_)
+        return false;
+
+#ifndef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
+    // Every point but the first one must be reached after its predecessor
+    if (timeIncrement == 0 && !firstPoint_)
+        return false;
+#endif
+
+    // A slot is always left empty, telling a full buffer from an empty one
+    uint8_t head = head_;
+    uint8_t nextHead = head + 1 == bufferSize_ ? 0 : head + 1;
+    if (nextHead == tail_)
+        return false;
+
+    buffer_[head].speed = speed;
+    buffer_[head].time = timeIncrement;
+#ifndef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
+    firstPoint_ = false;
+#endif
+
+    // Publish the point once it's fully written
+    halCompilerBarrier();
+    head_ = nextHead;
+    return true;
+}
+
+/**
+ * Closes the stream
+ */
+void SpinStream::close()
+{
+    closed_ = true;
+}
+
+/**
+ * Empties and reopens the stream
+ */
+void SpinStream::reset()
+{
+    head_ = tail_ = 0;
+    closed_ = false;
+#ifndef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
+    firstPoint_ = true;
+#endif
+    resetStats_();
+}
+
+/**
+ * Returns the number of points stored in the stream
+ * @returns {uint8_t} Points appended and not yet consumed by the spinner
+ */
+uint8_t SpinStream::available()
+{
+    uint8_t head = head_;
+    uint8_t tail = tail_;
+    return head >= tail ? head - tail : bufferSize_ - tail + head;
+}
+
+/**
+ * Returns the number of points that can be appended to the stream
+ * @returns {uint8_t} Free buffer points
+ */
+uint8_t SpinStream::space()
+{
+    return bufferSize_ - 1 - available();
+}
+
+/**
+ * Returns the number of underruns since the spin start
+ * @returns {uint16_t} Number of underruns
+ */
+uint16_t SpinStream::underruns()
+{
+    // The counter is updated by the spinner, maybe from an interrupt
+    HalInterruptState interruptState = halDisableInterrupts();
+    uint16_t underruns = underruns_;
+    halRestoreInterrupts(interruptState);
+    return underruns;
+}
+
+/**
+ * Returns the low-water mark since the spin start
+ * @returns {uint8_t} Lowest number of stored points after the spinner consumed a point
+ */
+uint8_t SpinStream::lowWaterMark()
+{
+    return lowWaterMark_;
+}
+
+// Private functions definition
+
+/**
+ * Takes the oldest point of the stream
+ * @param {SpinPoint*} spinPoint - Taken point
+ * @returns {bool} True if a point was taken, false if the stream is empty
+ */
+bool SpinStream::read_(SpinPoint *spinPoint)
+{
+    uint8_t tail = tail_;
+    if (tail == head_)
+        return false;
+
+    // Read the point before releasing its slot to the producer
+    *spinPoint = buffer_[tail];
+    halCompilerBarrier();
+    tail_ = tail + 1 == bufferSize_ ? 0 : tail + 1;
+
+    uint8_t stored = available();
+    if (stored < lowWaterMark_)
+        lowWaterMark_ = stored;
+    return true;
+}
+
+/**
+ * Resets the underruns count and the low-water mark
+ */
+void SpinStream::resetStats_()
+{
+    underruns_ = 0;
+    lowWaterMark_ = 0xFF;
+}
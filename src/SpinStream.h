@@ -0,0 +1,94 @@
+// SpinStream.h
+// Header file for SpinStream class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SPIN_STREAM_H
+#define SPIN_STREAM_H
+
+#include "Spinner.h"
+
+/**
+ * Spin map streamed to a spinner through a ring buffer, whose points can be appended while spinning
+ * @class
+ * @note Stream point times are the time increments, in milliseconds, since the previous stream point
+ */
+class SpinStream
+{
+public:
+    /**
+     * Creates a spin stream
+     * @constructor
+     * @param {SpinPoint[]} buffer - Ring buffer storing the points appended and not yet reached by the spinner
+     * @param {uint8_t} bufferSize - Number of spin points of the buffer, from 2 to 255. The stream holds up to bufferSize - 1 points
+     */
+    SpinStream(SpinPoint buffer[], uint8_t bufferSize);
+
+    /**
+     * Appends a point to the stream
+     * @param {uint16_t} speed - Spin speed, from 0 to 65535
+     * @param {uint16_t} timeIncrement - Time, in milliseconds, to reach the speed since the previous stream point. Ignored on the first stream point
+     * @returns {bool} True if the point was appended, false if the buffer is full, the stream is closed or the time increment is zero
+     * @note A zero time increment is accepted on the first stream point, or on any point if TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK is defined
+     */
+    bool append(uint16_t speed, uint16_t timeIncrement);
+
+    /**
+     * Closes the stream, so that the spin finishes once the spinner reaches its last point
+     * @note An open stream running out of points is an underrun: the spinner keeps the reached speed until a new point is appended
+     */
+    void close();
+
+    /**
+     * Empties and reopens the stream
+     * @note The stream must not be spun while it's reset
+     */
+    void reset();
+
+    /**
+     * Returns the number of points stored in the stream
+     * @returns {uint8_t} Points appended and not yet consumed by the spinner
+     */
+    uint8_t available();
+
+    /**
+     * Returns the number of points that can be appended to the stream
+     * @returns {uint8_t} Free buffer points
+     */
+    uint8_t space();
+
+    /**
+     * Returns the number of underruns since the spin start
+     * @returns {uint16_t} Number of times the spinner reached the last stream point of an open stream
+     */
+    uint16_t underruns();
+
+    /**
+     * Returns the low-water mark since the spin start
+     * @returns {uint8_t} Lowest number of stored points after the spinner consumed a point
+     */
+    uint8_t lowWaterMark();
+
+private:
+    friend class Spinner;
+
+    SpinPoint *buffer_;
+    uint8_t bufferSize_;
+
+    // Single producer, single consumer ring: the head is only moved by append()
+    // and the tail by the spinner, so no critical section is needed
+    volatile uint8_t head_;
+    volatile uint8_t tail_;
+    volatile bool closed_;
+#ifndef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
+    bool firstPoint_;
+#endif
+
+    volatile uint16_t underruns_;
+    volatile uint8_t lowWaterMark_;
+
+    bool read_(SpinPoint *);
+    void resetStats_();
+};
+
+#endif
@@ -4,29 +4,109 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include "Spinner.h"
+#include "SpinStream.h"
+#include "CompiledSpinMap.h"
+#include "SpinProfile.h"
 #include "math.h"
 
+// Spinner events, as pending event flags
+static const uint8_t kSpinUpdatedEvent = 0x01;
+static const uint8_t kSpinFinishedEvent = 0x02;
+
+// Map segments the spin course is linearly advanced before falling back to a binary search
+static const uint8_t kSpinMapScanSteps = 2;
+
+// Curve tables: shape of the S-curve (smoothstep, 3u^2 - 2u^3) and exponential (1 - e^(-4u), normalized)
+// segment curves, sampled at 65 points of the segment progress u and scaled from 0 to 65535
+static const uint8_t kCurveTableBits = 6;
+static const uint16_t kSCurveTable[] PROGMEM = {
+    0, 47, 188, 418, 736, 1137, 1620, 2180,
+    2816, 3523, 4300, 5142, 6048, 7013, 8036, 9112,
+    10240, 11415, 12636, 13898, 15200, 16537, 17908, 19308,
+    20736, 22187, 23660, 25150, 26656, 28173, 29700, 31232,
+    32768, 34303, 35835, 37362, 38879, 40385, 41875, 43348,
+    44799, 46227, 47627, 48998, 50335, 51637, 52899, 54120,
+    55295, 56423, 57499, 58522, 59487, 60393, 61235, 62012,
+    62719, 63355, 63915, 64398, 64799, 65117, 65347, 65488,
+    65535};
+static const uint16_t kExponentialTable[] PROGMEM = {
+    0, 4045, 7844, 11414, 14767, 17917, 20876, 23656,
+    26267, 28720, 31025, 33190, 35224, 37134, 38929, 40615,
+    42199, 43687, 45085, 46398, 47631, 48790, 49879, 50901,
+    51862, 52765, 53612, 54409, 55157, 55860, 56520, 57140,
+    57723, 58270, 58785, 59268, 59721, 60148, 60548, 60924,
+    61278, 61610, 61922, 62215, 62490, 62749, 62991, 63220,
+    63434, 63635, 63825, 64002, 64169, 64326, 64473, 64612,
+    64742, 64864, 64979, 65086, 65188, 65283, 65372, 65456,
+    65535};
+
+/**
+ * Reads a little endian 16-bit word of a packed spin map
+ * @param {const uint8_t*} address - Flash memory address of the word low byte
+ * @returns {uint16_t} Read word
+ * @note The word is read byte by byte, since packed map words are not aligned
+ */
+static uint16_t readPackedWord(const uint8_t *address)
+{
+    return halReadFlashByte(address) | (uint16_t)halReadFlashByte(address + 1) << 8;
+}
+
 // Public functions definition
 
 /**
  * Creates an acceleration/deceleration controller
  * for TB6612FNG driven motors
  * @constructor
- * @param {Motor*} motor - Pointer to a Motor object instance
+ * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
  */
-Spinner::Spinner(Motor *motor) : Spinner(motor, NULL, NULL){};
+Spinner::Spinner(MotorInterface *motor) : Spinner(motor, NULL, NULL){};
 
 /**
  * Creates an acceleration/deceleration controller
  * for TB6612FNG driven motors and use callbacks for handling its events
  * @constructor
- * @param {Motor*} motor - Pointer to a Motor object instance
+ * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
  * @param {SpinnerCB} spinUpdated -Callback function for handling the spin updated event
  * @param {SpinnerCB} spinFinished - Callback function for handling the spin finished event
  */
-Spinner::Spinner(Motor *motor, SpinnerCB spinUpdated, SpinnerCB spinFinished) : motor_(motor), spinUpdatedCB_(spinUpdated), spinFinishedCB_(spinFinished)
+Spinner::Spinner(MotorInterface *motor, SpinnerCB spinUpdated, SpinnerCB spinFinished) : Spinner(motor, (SpinnerContextCB)NULL, (SpinnerContextCB)NULL, NULL)
 {
+    spinUpdatedCB_ = spinUpdated;
+    spinFinishedCB_ = spinFinished;
+}
+
+/**
+ * Creates an acceleration/deceleration controller
+ * for TB6612FNG driven motors and use callbacks receiving a user context for handling its events
+ * @constructor
+ * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+ * @param {SpinnerContextCB} spinUpdated - Callback function for handling the spin updated event
+ * @param {SpinnerContextCB} spinFinished - Callback function for handling the spin finished event
+ * @param {void*} context - User context passed to the callbacks
+ */
+Spinner::Spinner(MotorInterface *motor, SpinnerContextCB spinUpdated, SpinnerContextCB spinFinished, void *context) : motor_(motor), spinUpdatedContextCB_(spinUpdated), spinFinishedContextCB_(spinFinished), context_(context)
+{
+    spinUpdatedCB_ = NULL;
+    spinFinishedCB_ = NULL;
+    updateMinInterval_ = 0;
+    updateMinSpeedDelta_ = 0;
+    updateRaised_ = false;
     map_ = NULL;
+    timebase_ = Milliseconds;
+    scheduled_ = false;
+    pendingEvents_ = 0;
+    grouped_ = false;
+    outputPending_ = false;
+    speedMask_ = 0;
+    zeroSpeedMode_ = Coast;
+    reversalDwell_ = 0;
+    outputSign_ = 0;
+    dwelling_ = false;
+    dwellEndTime_ = 0;
+    loopsLeft_ = 0;
+#if defined(TB6612FNG_SPIN_STATS)
+    resetStats();
+#endif
 }
 
 /**
@@ -51,24 +131,136 @@ const SpinPoint *Spinner::start(Direction direction, SpinPoint spinMap[])
  */
 const SpinPoint *Spinner::start(Direction direction, SpinPoint spinMap[], uint8_t spinMapSize)
 {
-    // Check the spinMap integrity
-    if (!checkSpinMap_(spinMap, spinMapSize))
+    return start_(direction, spinMap, kRamMap, spinMapSize, NULL);
+}
+
+/**
+ * Starts a motor acceleration/deceleration defined by two or more spin points and the curves of its segments
+ * @param {Direction} direction - Motor rotation direction
+ * @param {SpinPoint[]} spinMap - Spin map containing two or more points
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::start(Direction direction, SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[])
+{
+    return start_(direction, spinMap, kRamMap, spinMapSize, segmentCurves);
+}
+
+/**
+ * Starts a motor lineal acceleration/deceleration defined by a map with signed speeds
+ * @param {Direction} direction - Motor rotation direction of the positive velocities
+ * @param {SignedSpinPoint[]} spinMap - Spin map containing two or more signed points
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::start(Direction direction, SignedSpinPoint spinMap[], uint8_t spinMapSize)
+{
+    return start_(direction, spinMap, kSignedMap, spinMapSize, NULL);
+}
+
+/**
+ * Starts a motor acceleration/deceleration defined by a map with signed speeds and the curves of its segments
+ * @param {Direction} direction - Motor rotation direction of the positive velocities
+ * @param {SignedSpinPoint[]} spinMap - Spin map containing two or more signed points
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::start(Direction direction, SignedSpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[])
+{
+    return start_(direction, spinMap, kSignedMap, spinMapSize, segmentCurves);
+}
+
+/**
+ * Starts a motor lineal acceleration/deceleration defined by a map stored in flash memory
+ * @param {Direction} direction - Motor rotation direction
+ * @param {const SpinPoint[]} spinMap - Spin map containing two or more points, declared with PROGMEM
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::startFlash(Direction direction, const SpinPoint spinMap[], uint8_t spinMapSize)
+{
+    return start_(direction, spinMap, kFlashMap, spinMapSize, NULL);
+}
+
+/**
+ * Starts a motor acceleration/deceleration defined by a map and the curves of its segments stored in flash memory
+ * @param {Direction} direction - Motor rotation direction
+ * @param {const SpinPoint[]} spinMap - Spin map containing two or more points, declared with PROGMEM
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, declared with PROGMEM
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::startFlash(Direction direction, const SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[])
+{
+    return start_(direction, spinMap, kFlashMap, spinMapSize, segmentCurves);
+}
+
+/**
+ * Starts a motor lineal acceleration/deceleration defined by a packed map stored in flash memory
+ * @param {Direction} direction - Motor rotation direction
+ * @param {const uint8_t[]} packedSpinMap - Packed spin map containing two or more points, declared with PROGMEM
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::startPacked(Direction direction, const uint8_t packedSpinMap[], uint8_t spinMapSize)
+{
+    return start_(direction, packedSpinMap, kPackedMap, spinMapSize, NULL);
+}
+
+/**
+ * Starts a motor lineal acceleration/deceleration defined by the points of a stream
+ * @param {Direction} direction - Motor rotation direction
+ * @param {SpinStream*} spinStream - Stream storing at least the first spin point
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first stream point or null if the stream is empty
+ */
+const SpinPoint *Spinner::start(Direction direction, SpinStream *spinStream)
+{
+    if (spinStream->available() == 0)
         return NULL;
 
-    // Store the map size
-    mapSize_ = spinMapSize;
+    return start_(direction, spinStream, kStream, 2, NULL);
+}
 
-    // Initialize the plan variables
-    map_ = spinMap;
-    spinDirection_ = direction;
+/**
+ * Starts a motor acceleration/deceleration defined by a compiled spin map
+ * @param {Direction} direction - Motor rotation direction
+ * @param {CompiledSpinMap*} compiledSpinMap - Spin map compiled for the spinner timebase
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::start(Direction direction, CompiledSpinMap *compiledSpinMap)
+{
+    // The compiled slopes are increments per tick of the timebase the map was compiled for
+    if (compiledSpinMap->timebase_ != timebase_)
+        return NULL;
 
-    // Start executing the plan
-    spinStartTime_ = millis();
-    currentSpinPoint_.time = 0;
-    currentSpinPoint_.speed = map_[0].speed;
-    updateSpeed_(motor_, spinDirection_, &currentSpinPoint_, spinUpdatedCB_);
+    return start_(direction, compiledSpinMap->segments_, kCompiledMap, compiledSpinMap->size_, NULL);
+}
 
-    return &currentSpinPoint_;
+/**
+ * Starts a motor acceleration/deceleration defined by a spin profile
+ * @param {Direction} direction - Motor rotation direction
+ * @param {SpinProfile*} spinProfile - Spin profile
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first profile point or null if the start operation cannot be executed
+ */
+const SpinPoint *Spinner::start(Direction direction, SpinProfile *spinProfile)
+{
+    // Profile times are spun in timebase ticks, so they must fit in them
+    uint8_t size = spinProfile->size_;
+    if (size < 2 || spinProfile->points_[size - 1].time > 0xFFFFFFFE / timebase_)
+        return NULL;
+
+    return start_(direction, spinProfile, kProfile, size, spinProfile->curves_);
 }
 
 /**
@@ -78,61 +270,285 @@ const SpinPoint *Spinner::start(Direction direction, SpinPoint spinMap[], uint8_
  */
 const SpinPoint *Spinner::spin()
 {
-    uint8_t currentmapPointIndex;
+    return spin(getTime_());
+}
+
+/**
+ * Updates a running spin operation at a given time
+ * @param {unsigned long} time - Current time in timebase ticks
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the last reached spin map point, or null if no spin operation is in progress.
+ */
+const SpinPoint *Spinner::spin(unsigned long time)
+{
+#if defined(TB6612FNG_SPIN_STATS)
+    // If there's no map, there's no spin in progress: quit
+    if (map_ == NULL)
+        return NULL;
+
+    // Time the spin update, excluding the callbacks it calls
+    unsigned long startMicros = halMicros();
+    unsigned long callbackTime = stats_.callbackTime;
+    recordInterval_(getElapsedTime_(time, spinStartTime_) - spinElapsedTime_);
+    const SpinPoint *spinPoint = spin_(time);
+    stats_.spinTime += halMicros() - startMicros - (stats_.callbackTime - callbackTime);
+    return spinPoint;
+#else
+    return spin_(time);
+#endif
+}
+
+/**
+ * Gets the time at which the next spin update is due
+ * @param {unsigned long*} dueTime - Due time, in timebase ticks
+ * @returns {bool} True if the due time was got, false if no spin operation is in progress
+ * @note The segment speed is monotonic, so the first speed change is binary searched
+ *  between the last spin update and the segment end
+ */
+bool Spinner::nextUpdateDue(unsigned long *dueTime)
+{
+    // Scheduled spinners are concurrently spun from an interrupt:
+    // their spin state cannot change while it's read
+    HalInterruptState interruptState = 0;
+    if (scheduled_)
+        interruptState = halDisableInterrupts();
+
+    bool spinning = map_ != NULL;
+    if (spinning)
+    {
+        unsigned long elapsedTime;
+        if (currentMapPointIndex_ == mapSize_ - 1)
+        {
+            // A held stream point is polled for new stream points on every timebase tick
+            elapsedTime = spinElapsedTime_ + 1;
+        }
+        else
+        {
+            // If the speed doesn't change up to the segment end,
+            // the update is due when the next segment is entered
+            unsigned long first = spinElapsedTime_ + 1;
+            unsigned long last = segmentEndTime_ + 1;
+            while (first < last)
+            {
+                unsigned long middle = first + (last - first) / 2;
+                if ((getSpeed_(middle, false) ^ speedMask_) != currentSpinPoint_.speed)
+                    last = middle;
+                else
+                    first = middle + 1;
+            }
+            elapsedTime = first;
+        }
+
+        // The end of a reversal dwell sets the speed too
+        if (dwelling_ && dwellEndTime_ < elapsedTime)
+            elapsedTime = dwellEndTime_;
+        *dueTime = spinStartTime_ + elapsedTime;
+    }
+
+    if (scheduled_)
+        halRestoreInterrupts(interruptState);
+    return spinning;
+}
+
+/**
+ * Aborts a spin operation, keeping the motor rotating 
+ * at the last speed reached by the aborted spin operation.
+ * @returns Pointer to a SpinPoint struct containing the last reached spin map point, 
+ *  or null if no spin operation was aborted.
+ */
+const SpinPoint *Spinner::abort()
+{
+    // Scheduled spinners are concurrently spun from an interrupt:
+    // the map pointer takes several writes on 8-bit cores, so it cannot be read while it's dropped
+    HalInterruptState interruptState = 0;
+    if (scheduled_)
+        interruptState = halDisableInterrupts();
+
+    // If there's no map, there's no spin in progress: nothing is aborted.
+    // Else drop the spin map and return the last spin point set
+    const SpinPoint *spinPoint = map_ == NULL ? NULL : &currentSpinPoint_;
+    map_ = NULL;
+
+    if (scheduled_)
+        halRestoreInterrupts(interruptState);
+    return spinPoint;
+}
+
+/**
+ * Sets the timebase used for calculating the spin speeds
+ * @param {SpinTimebase} timebase - Timebase
+ */
+void Spinner::timebase(SpinTimebase timebase)
+{
+    // Scheduled spinners are concurrently spun from an interrupt:
+    // the timebase cannot change while it's read
+    HalInterruptState interruptState = 0;
+    if (scheduled_)
+        interruptState = halDisableInterrupts();
+
+    // A running spin cannot change its time scale: abort it
+    abort();
+    timebase_ = timebase;
+
+    if (scheduled_)
+        halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Returns the timebase used for calculating the spin speeds
+ * @returns {SpinTimebase} Timebase
+ */
+SpinTimebase Spinner::timebase()
+{
+    return timebase_;
+}
+
+/**
+ * Sets the motor outputs at zero speed, and the dwell of the motor at zero speed when a signed map reverses it
+ * @param {ZeroSpeedMode} mode - Coast to stop the motor, Brake to short-brake it
+ * @param {uint16_t} reversalDwell - Milliseconds the motor is kept at zero speed after every zero crossing of a signed map
+ */
+void Spinner::zeroSpeed(ZeroSpeedMode mode, uint16_t reversalDwell)
+{
+    zeroSpeedMode_ = mode;
+    reversalDwell_ = reversalDwell;
+}
+
+/**
+ * Decimates the spin updated events, raising them only after a given time or speed change
+ * @param {uint16_t} minInterval - Milliseconds from the last raised event
+ * @param {uint16_t} minSpeedDelta - Speed change from the last raised event
+ */
+void Spinner::updateFilter(uint16_t minInterval, uint16_t minSpeedDelta)
+{
+    updateMinInterval_ = minInterval;
+    updateMinSpeedDelta_ = minSpeedDelta;
+}
+
+#if defined(TB6612FNG_SPIN_STATS)
+/**
+ * Gets the timing statistics collected since the spinner creation or the last statistics reset
+ * @param {SpinStats*} stats - Struct the statistics are copied to
+ */
+void Spinner::stats(SpinStats *stats)
+{
+    // Scheduled spinners update their statistics from an interrupt: copy them atomically
+    HalInterruptState interruptState = halDisableInterrupts();
+    *stats = stats_;
+    halRestoreInterrupts(interruptState);
+}
 
+/**
+ * Resets the timing statistics
+ */
+void Spinner::resetStats()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    stats_ = SpinStats();
+    stats_.minInterval = ~0UL;
+    halRestoreInterrupts(interruptState);
+}
+#endif
+
+// Private functions definition
+
+/**
+ * Updates a running spin operation at a given time
+ * @param {unsigned long} time - Current time in timebase ticks
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the last reached spin map point, or null if no spin operation is in progress.
+ */
+const SpinPoint *Spinner::spin_(unsigned long time)
+{
     // If there's no map, there's no spin in progress: quit
     if (map_ == NULL)
         return NULL;
 
-    // Get the elapsed time since the spin start
-    unsigned long spinElapsedTime = getElapsedTime_(spinStartTime_);
-    if (spinElapsedTime == currentSpinPoint_.time)
+    // Get the elapsed time, in timebase ticks, since the spin start
+    unsigned long spinElapsedTime = getElapsedTime_(time, spinStartTime_);
+    if (spinElapsedTime == spinElapsedTime_)
     {
         // No elapsed time since the last spin update
         // Return the last spin point and quit
         return &currentSpinPoint_;
     }
+#if defined(TB6612FNG_SPIN_STATS)
+    unsigned long previousElapsedTime = spinElapsedTime_;
+#endif
 
-    // Get the index of the current map point
-    currentmapPointIndex = refreshSpinCourse_(map_, mapSize_, spinElapsedTime);
+    // Looping profiles go back to their loop point once their last point is passed
+    unsigned long loopTime = mapStorage_ == kProfile ? loopProfile_(spinElapsedTime) : 0;
+    spinElapsedTime -= loopTime;
+#if defined(TB6612FNG_SPIN_STATS)
+    previousElapsedTime -= loopTime;
+#endif
+    spinElapsedTime_ = spinElapsedTime;
 
-    // Set the new speed
-    uint16_t newSpeed;
-    if (currentmapPointIndex == mapSize_ - 1)
+    // If the current segment end was passed, move the current map point forward up to the elapsed time
+    if (spinElapsedTime > segmentEndTime_ || loopTime != 0)
     {
-        // The spin is beyond the latest map point: the operation is finished
-        // and the current speed is the latest map point speed
-        newSpeed = map_[currentmapPointIndex].speed;
-    }
-    else
-    {
-        // The spin is between two map poins: Get the current intermediate point speed
-        newSpeed = getLinePointY_(map_[currentmapPointIndex].time,
-                                  map_[currentmapPointIndex].speed,
-                                  map_[currentmapPointIndex + 1].time,
-                                  map_[currentmapPointIndex + 1].speed,
-                                  spinElapsedTime - map_[currentmapPointIndex].time);
+        if (mapStorage_ == kPackedMap)
+        {
+            // Packed maps can only be decoded forward, one point at a time
+            do
+                advanceSegment_();
+            while (currentMapPointIndex_ < mapSize_ - 1 && spinElapsedTime > (unsigned long)segmentEndPoint_.time * timebase_);
+        }
+        else if (mapStorage_ == kStream)
+        {
+            advanceStream_(spinElapsedTime);
+        }
+        else
+        {
+            loadSegment_(refreshSpinCourse_(map_, mapStorage_, mapSize_, currentMapPointIndex_, spinElapsedTime, timebase_));
+        }
+        enterSegment_();
     }
 
+    // Set the new speed
+    uint16_t newSpeed = getSpeed_(spinElapsedTime, true) ^ speedMask_;
+
+#if defined(TB6612FNG_SPIN_STATS)
+    // A late call skips steps if the speed of the previous tick differs from the last speed set
+    if (newSpeed != currentSpinPoint_.speed && spinElapsedTime - previousElapsedTime > 1 &&
+        ((spinElapsedTime - 1 < segmentStartTime_ ? segmentStartPoint_.speed : getSpeed_(spinElapsedTime - 1, false)) ^ speedMask_) != currentSpinPoint_.speed)
+        stats_.skippedSteps++;
+#endif
+
+    // Signed maps keep the motor at zero speed after a zero crossing, and set the speed again once the dwell ends
+    bool dwellEnded = speedMask_ != 0 && updateReversal_(newSpeed, spinElapsedTime);
+
     // If the new speed is different to that previously set,
     // update the motor speed and call the spinUpdate callback (if defined)
-    if (newSpeed != currentSpinPoint_.speed)
+    if (newSpeed != currentSpinPoint_.speed || dwellEnded)
     {
         // The new point speed is different to the lastest set: Update it
         currentSpinPoint_.speed = newSpeed;
-        currentSpinPoint_.time = spinElapsedTime;
-        updateSpeed_(motor_, spinDirection_, &currentSpinPoint_, spinUpdatedCB_);
+        currentSpinPoint_.time = getMillis_(spinElapsedTime);
+        updateSpeed_(motor_, spinDirection_, &currentSpinPoint_);
     }
 
-    // If the map is completed, drop it and call the spin Finished callback (if defined)
-    if (currentmapPointIndex == mapSize_ - 1)
+    // If the map is completed, drop it and call the spin Finished callback (if defined).
+    // An open stream is never completed: it's waiting for new points
+    if (currentMapPointIndex_ == mapSize_ - 1 && (mapStorage_ != kStream || ((SpinStream *)map_)->closed_))
     {
         map_ = NULL;
-        if (spinFinishedCB_)
+
+        // A reversal dwell doesn't outlast the map: the last map speed is set
+        if (dwelling_)
+        {
+            dwelling_ = false;
+            if (grouped_)
+                outputPending_ = true;
+            else
+                writeSpeed_(motor_, spinDirection_, newSpeed);
+        }
+
+        if (hasCallback_(kSpinFinishedEvent))
         {
             currentSpinPoint_.speed = newSpeed;
-            currentSpinPoint_.time = spinElapsedTime;
-            spinFinishedCB_(&currentSpinPoint_);
+            currentSpinPoint_.time = getMillis_(spinElapsedTime);
+            raiseEvent_(&currentSpinPoint_, kSpinFinishedEvent);
         }
     }
 
@@ -140,50 +556,136 @@ const SpinPoint *Spinner::spin()
 }
 
 /**
- * Aborts a spin operation, keeping the motor rotating 
- * at the last speed reached by the aborted spin operation.
- * @returns Pointer to a SpinPoint struct containing the last reached spin map point, 
- *  or null if no spin operation was aborted.
+ * Starts a motor lineal acceleration/deceleration defined by a map stored in a given memory
+ * @param {Direction} direction - Motor rotation direction
+ * @param {const void*} spinMap - Spin map, as an array of spin points or as a packed map
+ * @param {MapStorage} mapStorage - Memory the spin map is read from
+ * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+ * @param {const uint8_t*} segmentCurves - SpinCurve of every map segment, stored in the same memory than the map, or null if all the segments are linear
+ * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct 
+ *  containing the first spin map point or null if the start operation cannot be executed
  */
-const SpinPoint *Spinner::abort()
+const SpinPoint *Spinner::start_(Direction direction, const void *spinMap, MapStorage mapStorage, uint8_t spinMapSize, const uint8_t *segmentCurves)
 {
-    // If there's no map, there's no spin in progress: quit
-    if (map_ == NULL)
+    // Check the spinMap integrity
+    if (!checkSpinMap_(spinMap, mapStorage, spinMapSize, segmentCurves))
         return NULL;
 
-    // Drop the spin map and return the last spin point set
-    map_ = NULL;
+    // Scheduled spinners are concurrently spun from an interrupt:
+    // the spin start cannot be interrupted
+    HalInterruptState interruptState = 0;
+    if (scheduled_)
+        interruptState = halDisableInterrupts();
+
+    // Store the map size
+    mapSize_ = spinMapSize;
+
+    // Initialize the plan variables
+    map_ = spinMap;
+    mapStorage_ = mapStorage;
+    curves_ = segmentCurves;
+    spinDirection_ = direction;
+    speedMask_ = mapStorage == kSignedMap ? 0x8000 : 0;
+    dwelling_ = false;
+    updateRaised_ = false;
+    if (mapStorage == kProfile)
+    {
+        const SpinProfile *profile = (const SpinProfile *)spinMap;
+        loopsLeft_ = profile->loopCount_;
+        profileEndTime_ = getPointTime_(spinMap, mapStorage, spinMapSize - 1, timebase_);
+        loopDuration_ = loopsLeft_ == 0 ? 0 : profileEndTime_ - getPointTime_(spinMap, mapStorage, profile->loopIndex_, timebase_);
+    }
+
+    // Start executing the plan
+    spinStartTime_ = getTime_();
+    spinElapsedTime_ = 0;
+    loadSegment_(0);
+    enterSegment_();
+    currentSpinPoint_.time = 0;
+    currentSpinPoint_.speed = segmentStartPoint_.speed ^ speedMask_;
+    outputSign_ = (int16_t)currentSpinPoint_.speed > 0 ? 1 : (int16_t)currentSpinPoint_.speed < 0 ? -1 : 0;
+    updateSpeed_(motor_, spinDirection_, &currentSpinPoint_);
+
+    if (scheduled_)
+        halRestoreInterrupts(interruptState);
+
     return &currentSpinPoint_;
 }
 
-// Private functions definition
-
 /**
  * Checks the integrity of a spin map
- * @param {SpinPoint[]} spinMap - Spin map
- * @param {uint8_t} mapSize_ - Spin map items
+ * @param {const void*} spinMap - Spin map
+ * @param {MapStorage} mapStorage - Memory the spin map is read from
+ * @param {uint8_t} mapSize - Spin map items
+ * @param {const uint8_t*} segmentCurves - SpinCurve of every map segment, or null
  * @returns {bool} True if the spin map passes the integrity checks
  */
-bool Spinner::checkSpinMap_(SpinPoint spinMap[], uint8_t mapSize_)
+bool Spinner::checkSpinMap_(const void *spinMap, MapStorage mapStorage, uint8_t mapSize, const uint8_t *segmentCurves)
 {
 #ifdef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
     return true;
 #else
     // Maps with less than two points are not allowed
-    if (mapSize_ < 2)
+    if (mapSize < 2)
         return false;
 
+    // Stream point time increments are checked by SpinStream::append(), and compiled maps while they're compiled
+    if (mapStorage == kStream || mapStorage == kCompiledMap)
+        return true;
+
+    // Every segment curve must be a SpinCurve value
+    for (int i = 0; segmentCurves != NULL && i < mapSize - 1; i++)
+    {
+        uint8_t curve = mapStorage == kFlashMap ? halReadFlashByte(&segmentCurves[i]) : segmentCurves[i];
+        if (curve > Exponential)
+            return false;
+    }
+
+    if (mapStorage == kProfile)
+    {
+        // First profile point time must be zero, and every point time must be higher than its predecessor's
+        const LongSpinPoint *points = ((const SpinProfile *)spinMap)->points_;
+        if (points[0].time != 0)
+            return false;
+        for (int i = 1; i < mapSize; i++)
+        {
+            if (points[i].time <= points[i - 1].time)
+                return false;
+        }
+        return true;
+    }
+
+    SpinPoint spinPoint;
+    if (mapStorage == kPackedMap)
+    {
+        // The first packed map point time is always zero, and the time and speed
+        // increments of the remaining points must be valid
+        const uint8_t *cursor = (const uint8_t *)spinMap;
+        spinPoint.time = 0;
+        spinPoint.speed = readPackedWord(cursor);
+        cursor += 2;
+        for (int i = 1; i < mapSize; i++)
+        {
+            if (!decodePackedPoint_(&cursor, &spinPoint))
+                return false;
+        }
+        return true;
+    }
+
     // First map point must set its time set to zero
-    if (spinMap[0].time != 0)
+    readMapPoint_(spinMap, mapStorage, 0, &spinPoint);
+    if (spinPoint.time != 0)
         return false;
 
-    // Every map point time must be higher than its predecessor's
-    uint16_t previousSpinTime = spinMap[0].time;
-    for (int i = 1; i < mapSize_; i++)
+    // Every map point time must be higher than its predecessor's, and signed map
+    // velocities must be in the range -32767 to 32767, ie, offset speeds higher than zero
+    uint16_t previousSpinTime = spinPoint.time;
+    for (int i = 0; i < mapSize; i++)
     {
-        if (spinMap[i].time <= previousSpinTime)
+        readMapPoint_(spinMap, mapStorage, i, &spinPoint);
+        if ((i > 0 && spinPoint.time <= previousSpinTime) || (mapStorage == kSignedMap && spinPoint.speed == 0))
             return false;
-        previousSpinTime = spinMap[i].time;
+        previousSpinTime = spinPoint.time;
     }
 
     // All tests successfully passed
@@ -192,71 +694,779 @@ bool Spinner::checkSpinMap_(SpinPoint spinMap[], uint8_t mapSize_)
 }
 
 /**
- * Gets the elapsed time, in milliseconds, since a given past time
- * @param {unsigned long} pastTime - Past time, in milliseconds
- * @returns {unsigned long} Ellapsed time between now and pastTime
+ * Reads a point of a spin map stored as an array of spin points
+ * @param {const void*} spinMap - Spin map
+ * @param {MapStorage} mapStorage - Memory the spin map is read from, RAM or flash, or compiled map
+ * @param {uint8_t} index - Index of the map point
+ * @param {SpinPoint*} spinPoint - Read map point
+ * @note Packed maps have no random access: they are decoded by decodePackedPoint_()
  */
-unsigned long Spinner::getElapsedTime_(unsigned long pastTime)
+void Spinner::readMapPoint_(const void *spinMap, MapStorage mapStorage, uint8_t index, SpinPoint *spinPoint)
 {
-    unsigned long now = millis();
-    if (now < pastTime)
+    if (mapStorage == kCompiledMap)
     {
-        // Arduino ellapsed time counter has overflowed
-        return 4294967295 - pastTime + now;
+        const CompiledSpinSegment *segment = (const CompiledSpinSegment *)spinMap + index;
+        spinPoint->speed = segment->speed;
+        spinPoint->time = segment->time;
+        return;
+    }
+
+    const SpinPoint *mapPoint = (const SpinPoint *)spinMap + index;
+    if (mapStorage == kFlashMap)
+    {
+        spinPoint->speed = halReadFlashWord(&mapPoint->speed);
+        spinPoint->time = halReadFlashWord(&mapPoint->time);
     }
     else
-        return now - pastTime;
+    {
+        *spinPoint = *mapPoint;
+    }
+
+    // Flipping the sign bit of a two's complement velocity offsets it by 32768
+    if (mapStorage == kSignedMap)
+        spinPoint->speed ^= 0x8000;
+}
+
+/**
+ * Gets the time of a point of a spin map stored as an array of points
+ * @param {const void*} spinMap - Spin map, or spin profile
+ * @param {MapStorage} mapStorage - Memory the spin map is read from
+ * @param {uint8_t} index - Index of the map point
+ * @param {uint16_t} ticksPerMillisecond - Timebase ticks per millisecond
+ * @returns {unsigned long} Map point time, in timebase ticks
+ */
+unsigned long Spinner::getPointTime_(const void *spinMap, MapStorage mapStorage, uint8_t index, uint16_t ticksPerMillisecond)
+{
+    if (mapStorage == kProfile)
+        return ((const SpinProfile *)spinMap)->points_[index].time * ticksPerMillisecond;
+
+    SpinPoint spinPoint;
+    readMapPoint_(spinMap, mapStorage, index, &spinPoint);
+    return (unsigned long)spinPoint.time * ticksPerMillisecond;
+}
+
+/**
+ * Decodes the next point of a packed spin map
+ * @param {const uint8_t**} cursor - Encoding of the point to decode, moved forward to the next point encoding
+ * @param {SpinPoint*} spinPoint - Previous map point, replaced by the decoded point
+ * @returns {bool} True if the point is valid, ie, if its time is higher than the previous point time
+ *  and both its time and speed are in the range 0 to 65535
+ */
+bool Spinner::decodePackedPoint_(const uint8_t **cursor, SpinPoint *spinPoint)
+{
+    const uint8_t *encoding = *cursor;
+    uint16_t timeIncrement = halReadFlashByte(encoding);
+    long speed;
+    if (timeIncrement != 0)
+    {
+        // Two bytes encoding: 8-bit time and speed increments
+        speed = (long)spinPoint->speed + (int8_t)halReadFlashByte(encoding + 1);
+        *cursor = encoding + 2;
+    }
+    else
+    {
+        // Five bytes encoding: zero mark, 16-bit time increment and absolute speed
+        timeIncrement = readPackedWord(encoding + 1);
+        speed = readPackedWord(encoding + 3);
+        *cursor = encoding + 5;
+    }
+
+    bool valid = timeIncrement != 0 && (unsigned long)spinPoint->time + timeIncrement <= 0xFFFF && speed >= 0 && speed <= 0xFFFF;
+    spinPoint->time += timeIncrement;
+    spinPoint->speed = (uint16_t)speed;
+    return valid;
+}
+
+/**
+ * Gets the current time in timebase ticks
+ * @returns {unsigned long} Current time, in milliseconds or microseconds depending on the timebase
+ */
+unsigned long Spinner::getTime_()
+{
+    return timebase_ == Milliseconds ? halMillis() : halMicros();
+}
+
+/**
+ * Converts a time in timebase ticks to milliseconds
+ * @param {unsigned long} time - Time, in timebase ticks
+ * @returns {unsigned long} Time, in milliseconds
+ * @note Spin point times are expressed in milliseconds whatever the timebase
+ */
+unsigned long Spinner::getMillis_(unsigned long time)
+{
+    return timebase_ == Milliseconds ? time : time / timebase_;
+}
+
+/**
+ * Gets the elapsed time, in timebase ticks, between two times
+ * @param {unsigned long} time - Current time, in timebase ticks
+ * @param {unsigned long} pastTime - Past time, in timebase ticks
+ * @returns {unsigned long} Ellapsed time between time and pastTime
+ * @note Unsigned subtraction keeps the elapsed time right when the Arduino time counter overflows
+ */
+unsigned long Spinner::getElapsedTime_(unsigned long time, unsigned long pastTime)
+{
+    return time - pastTime;
 }
 
 /**
  * Updates the motor speed and calls the spin update callback function (if defined)
- * @param {Motor*} motor - Motor object reference
+ * @param {MotorInterface*} motor - Motor object reference
  * @param {Direction} direction - Motor rotation direction
  * @param {SpinPoint*} spinPoint - Reference to spin point whose speed must be set
- * @param {SpinnerCB} spinUpdatedCB - Pointer to speed updated callback function
  */
-void Spinner::updateSpeed_(Motor *motor, Direction spinDirection, SpinPoint *spinPoint, SpinnerCB spinUpdatedCB)
+void Spinner::updateSpeed_(MotorInterface *motor, Direction spinDirection, SpinPoint *spinPoint)
 {
-    if (spinPoint->speed > 0)
+    if (grouped_)
     {
-        motor->run(spinDirection, spinPoint->speed);
+        // The group applies the output once all its members are spun
+        outputPending_ = true;
     }
     else
     {
+        writeSpeed_(motor, spinDirection, spinPoint->speed);
+    }
+
+    if (hasCallback_(kSpinUpdatedEvent) && filterUpdate_(spinPoint))
+        raiseEvent_(spinPoint, kSpinUpdatedEvent);
+}
+
+/**
+ * Sets the motor speed deferred by a grouped spinner, if any
+ */
+void Spinner::applyOutput_()
+{
+    if (!outputPending_)
+        return;
+
+    outputPending_ = false;
+    writeSpeed_(motor_, spinDirection_, currentSpinPoint_.speed);
+}
+
+/**
+ * Sets the motor speed
+ * @param {MotorInterface*} motor - Motor object reference
+ * @param {Direction} direction - Motor rotation direction
+ * @param {uint16_t} speed - Speed, or velocity in two's complement if a signed map is spun
+ */
+void Spinner::writeSpeed_(MotorInterface *motor, Direction direction, uint16_t speed)
+{
+    if (speedMask_ != 0)
+    {
+        // Velocities from 1 to 32767 are scaled to speeds from 2 to 65535, and negative
+        // velocities reverse the rotation direction
+        int16_t velocity = (int16_t)speed;
+        speed = velocity < 0 ? -velocity : velocity;
+        speed = dwelling_ ? 0 : (speed << 1) | (speed >> 14);
+        if (velocity < 0)
+            direction = direction == Clockwise ? CounterClockwise : Clockwise;
+    }
+
+    if (speed > 0)
+        motor->run(direction, speed);
+    else if (zeroSpeedMode_ == Brake)
+        motor->brake();
+    else
         motor->stop();
+}
+
+/**
+ * Tracks the zero crossings of a signed map, starting a reversal dwell on every one
+ * @param {uint16_t} speed - New velocity, in two's complement
+ * @param {unsigned long} elapsedTime - Elapsed time, in timebase ticks, since the spin start
+ * @returns {bool} True if a reversal dwell ended, so the speed must be set even if it didn't change
+ * @note A velocity reaching zero or changing its sign is a zero crossing. The dwell starts then,
+ *  and no further zero crossing is tracked until it ends
+ */
+bool Spinner::updateReversal_(uint16_t speed, unsigned long elapsedTime)
+{
+    int8_t sign = (int16_t)speed > 0 ? 1 : (int16_t)speed < 0 ? -1 : 0;
+    if (outputSign_ != 0 && sign != outputSign_)
+    {
+        outputSign_ = 0;
+        dwelling_ = reversalDwell_ > 0;
+        dwellEndTime_ = elapsedTime + (unsigned long)reversalDwell_ * timebase_;
     }
 
-    if (spinUpdatedCB != NULL)
-        spinUpdatedCB(spinPoint);
+    bool dwellEnded = dwelling_ && elapsedTime >= dwellEndTime_;
+    if (dwellEnded)
+        dwelling_ = false;
+    if (!dwelling_)
+        outputSign_ = sign;
+
+    return dwellEnded;
+}
+
+/**
+ * Checks whether a speed update reached the decimation thresholds since the last update raising an event
+ * @param {const SpinPoint*} spinPoint - Spin point with the updated speed
+ * @returns {bool} True if the spin updated event must be raised, else false
+ */
+bool Spinner::filterUpdate_(const SpinPoint *spinPoint)
+{
+    if (updateRaised_)
+    {
+        // Point times are 16-bit milliseconds, so their unsigned difference is the interval.
+        // Speeds are compared offset as spun, so that signed velocities are compared in order
+        uint16_t interval = spinPoint->time - raisedUpdatePoint_.time;
+        uint16_t speed = spinPoint->speed ^ speedMask_;
+        uint16_t raisedSpeed = raisedUpdatePoint_.speed ^ speedMask_;
+        uint16_t speedDelta = speed > raisedSpeed ? speed - raisedSpeed : raisedSpeed - speed;
+        if (interval < updateMinInterval_ || speedDelta < updateMinSpeedDelta_)
+            return false;
+    }
+
+    updateRaised_ = true;
+    raisedUpdatePoint_ = *spinPoint;
+    return true;
+}
+
+/**
+ * Returns if a callback function handles an event
+ * @param {uint8_t} event - Event flag
+ * @returns {bool} True if a plain or context callback function is defined for the event
+ */
+bool Spinner::hasCallback_(uint8_t event)
+{
+    if (event == kSpinUpdatedEvent)
+        return spinUpdatedCB_ || spinUpdatedContextCB_;
+    return spinFinishedCB_ || spinFinishedContextCB_;
+}
+
+/**
+ * Calls an event callback function (if defined) or, if the spinner is scheduled or grouped, defers it
+ * @param {SpinPoint*} spinPoint - Spin point passed to the callback function
+ * @param {uint8_t} event - Event flag
+ */
+void Spinner::raiseEvent_(SpinPoint *spinPoint, uint8_t event)
+{
+    if (!hasCallback_(event))
+        return;
+
+    if (!scheduled_ && !grouped_)
+    {
+        callback_(event, spinPoint);
+        return;
+    }
+
+    // Keep the event until it's dispatched from the main loop, or by the group.
+    // A pending event of the same kind is replaced by the newest one
+    if (event == kSpinUpdatedEvent)
+        pendingUpdatedPoint_ = *spinPoint;
+    else
+        pendingFinishedPoint_ = *spinPoint;
+    pendingEvents_ |= event;
+}
+
+/**
+ * Calls the callback functions of the pending events of a scheduled or grouped spinner
+ */
+void Spinner::dispatchEvents_()
+{
+    if (pendingEvents_ == 0)
+        return;
+
+    // Take the pending events without being interrupted by the scheduler
+    HalInterruptState interruptState = halDisableInterrupts();
+    uint8_t events = pendingEvents_;
+    SpinPoint updatedPoint = pendingUpdatedPoint_;
+    SpinPoint finishedPoint = pendingFinishedPoint_;
+    pendingEvents_ = 0;
+    halRestoreInterrupts(interruptState);
+
+    if (events & kSpinUpdatedEvent)
+        callback_(kSpinUpdatedEvent, &updatedPoint);
+    if (events & kSpinFinishedEvent)
+        callback_(kSpinFinishedEvent, &finishedPoint);
+}
+
+/**
+ * Calls the callback function of an event (if defined)
+ * @param {uint8_t} event - Event flag
+ * @param {const SpinPoint*} spinPoint - Spin point passed to the callback function
+ */
+void Spinner::callback_(uint8_t event, const SpinPoint *spinPoint)
+{
+#if defined(TB6612FNG_SPIN_STATS)
+    unsigned long startMicros = halMicros();
+#endif
+
+    SpinnerCB callback = event == kSpinUpdatedEvent ? spinUpdatedCB_ : spinFinishedCB_;
+    SpinnerContextCB contextCallback = event == kSpinUpdatedEvent ? spinUpdatedContextCB_ : spinFinishedContextCB_;
+    if (callback)
+        callback(spinPoint);
+    else if (contextCallback)
+        contextCallback(context_, spinPoint);
+
+#if defined(TB6612FNG_SPIN_STATS)
+    stats_.callbackTime += halMicros() - startMicros;
+#endif
 }
 
 /**
  * Returns the last reached spin map point given an elapsed time since the spin start
- * @param {SpinPoint*} map - Spin map, or array of spin points
+ * @param {const void*} map - Spin map, or array of spin points
+ * @param {MapStorage} mapStorage - Memory the spin map is read from, RAM or flash
  * @param {uint8_t} mapCount - Size of the spin map, ie, number of map points stored in the spin map
- * @param {unsigned long} elapsedTime - Elapsed time, in milliseconds, since the spin start
- * @returns {uint8_t} Index of the next map spin point
+ * @param {uint8_t} mapPoint - Index of the last reached spin map point in the previous refresh
+ * @param {unsigned long} elapsedTime - Elapsed time, in timebase ticks, since the spin start
+ * @param {uint16_t} ticksPerMillisecond - Timebase ticks per millisecond
+ * @returns {uint8_t} Index of the last reached spin map point
+ * @note The spin course only moves forward: the map is linearly scanned from mapPoint
+ *  for a few segments and, if the elapsed time is beyond them (for instance after a stalled loop),
+ *  the remaining map is binary searched. So a refresh costs O(1) amortized time whatever the map size.
  */
-uint8_t Spinner::refreshSpinCourse_(SpinPoint map[], uint8_t mapCount, unsigned long elapsedTime)
+uint8_t Spinner::refreshSpinCourse_(const void *map, MapStorage mapStorage, uint8_t mapCount, uint8_t mapPoint, unsigned long elapsedTime, uint16_t ticksPerMillisecond)
 {
-    uint8_t mapPoint = 0;
-    while (mapPoint < mapCount && elapsedTime > map[mapPoint].time)
+    // Linear scan of the next segments: the usual case when spin() is periodically called
+    for (uint8_t step = 0; step < kSpinMapScanSteps; step++)
     {
+        if (mapPoint == mapCount - 1)
+            return mapPoint;
+        if (elapsedTime <= getPointTime_(map, mapStorage, mapPoint + 1, ticksPerMillisecond))
+            return mapPoint;
         mapPoint++;
     }
-    return mapPoint < mapCount ? mapPoint - 1 : mapCount - 1;
+
+    // Large time jump: binary search of the last map point
+    // whose time is lower than the elapsed time
+    uint8_t lastMapPoint = mapCount - 1;
+    while (mapPoint < lastMapPoint)
+    {
+        uint8_t middleMapPoint = mapPoint + (lastMapPoint - mapPoint + 1) / 2;
+        if (elapsedTime > getPointTime_(map, mapStorage, middleMapPoint, ticksPerMillisecond))
+            mapPoint = middleMapPoint;
+        else
+            lastMapPoint = middleMapPoint - 1;
+    }
+    return mapPoint;
+}
+
+/**
+ * Loads the map segment starting at a given map point
+ * @param {uint8_t} mapPointIndex - Index of the map point starting the segment
+ * @note Packed maps can only be loaded from their first point, and then advanced by advanceSegment_()
+ */
+void Spinner::loadSegment_(uint8_t mapPointIndex)
+{
+    currentMapPointIndex_ = mapPointIndex;
+    if (mapStorage_ == kStream)
+    {
+        // The first stream point is held until the next one is taken
+        SpinStream *stream = (SpinStream *)map_;
+        stream->resetStats_();
+        stream->read_(&segmentStartPoint_);
+        segmentStartPoint_.time = 0;
+        currentMapPointIndex_ = 1;
+        advanceStream_(0);
+        return;
+    }
+    if (mapStorage_ == kPackedMap)
+    {
+        packedCursor_ = (const uint8_t *)map_;
+        segmentStartPoint_.time = 0;
+        segmentStartPoint_.speed = readPackedWord(packedCursor_);
+        packedCursor_ += 2;
+        segmentEndPoint_ = segmentStartPoint_;
+        decodePackedPoint_(&packedCursor_, &segmentEndPoint_);
+        return;
+    }
+
+    if (mapStorage_ == kProfile)
+    {
+        // Profile times don't fit in the segment points: the segment times are set here
+        const LongSpinPoint *point = &((const SpinProfile *)map_)->points_[mapPointIndex];
+        segmentStartPoint_.speed = point->speed;
+        segmentStartTime_ = point->time * timebase_;
+        if (mapPointIndex < mapSize_ - 1)
+        {
+            segmentEndPoint_.speed = point[1].speed;
+            segmentEndTime_ = point[1].time * timebase_;
+        }
+        return;
+    }
+
+    readMapPoint_(map_, mapStorage_, mapPointIndex, &segmentStartPoint_);
+    if (mapPointIndex < mapSize_ - 1)
+        readMapPoint_(map_, mapStorage_, mapPointIndex + 1, &segmentEndPoint_);
 }
 
+/**
+ * Moves a looping profile back to its loop point if its last point was passed
+ * @param {unsigned long} elapsedTime - Elapsed time, in timebase ticks, since the spin start
+ * @returns {unsigned long} Time the spin was moved back, in timebase ticks, or 0 if it didn't loop
+ * @note The spin start is moved forward by whole loop cycles, so the cycles are spun
+ *  back-to-back and don't drift however many of them are spun
+ */
+unsigned long Spinner::loopProfile_(unsigned long elapsedTime)
+{
+    if (loopsLeft_ == 0 || elapsedTime <= profileEndTime_)
+        return 0;
+
+    // Loop cycles needed to get back before the profile end, counted with a single division
+    // so that a late call (even from an interrupt) doesn't take a step per missed cycle
+    unsigned long loops = (elapsedTime - profileEndTime_ - 1) / loopDuration_ + 1;
+    if (loopsLeft_ != SPIN_LOOP_FOREVER)
+    {
+        if (loops > loopsLeft_)
+            loops = loopsLeft_;
+        loopsLeft_ -= loops;
+    }
+
+    unsigned long loopTime = loops * loopDuration_;
+    spinStartTime_ += loopTime;
+    loadSegment_(((const SpinProfile *)map_)->loopIndex_);
+    return loopTime;
+}
+
+/**
+ * Moves the current segment of a packed map to the next one, decoding its end point
+ */
+void Spinner::advanceSegment_()
+{
+    currentMapPointIndex_++;
+    segmentStartPoint_ = segmentEndPoint_;
+    if (currentMapPointIndex_ < mapSize_ - 1)
+        decodePackedPoint_(&packedCursor_, &segmentEndPoint_);
+}
+
+/**
+ * Moves the current segment of a stream up to a given elapsed time, taking the reached stream points
+ * @param {unsigned long} elapsedTime - Elapsed time, in timebase ticks, since the spin start
+ * @note Stream segment times are set here, since stream point times are relative to the previous point
+ */
+void Spinner::advanceStream_(unsigned long elapsedTime)
+{
+    SpinStream *stream = (SpinStream *)map_;
+    SpinPoint spinPoint;
+    while ((currentMapPointIndex_ != 0 || elapsedTime > segmentEndTime_) && stream->read_(&spinPoint))
+    {
+        if (currentMapPointIndex_ == 0)
+        {
+            // The segment end was reached: it starts the next segment
+            segmentStartPoint_ = segmentEndPoint_;
+            segmentStartTime_ = segmentEndTime_;
+        }
+        else
+        {
+            // The held point starts the next segment right now
+            segmentStartTime_ = elapsedTime;
+            currentMapPointIndex_ = 0;
+        }
+        segmentEndPoint_ = spinPoint;
+        segmentEndTime_ = segmentStartTime_ + (unsigned long)spinPoint.time * timebase_;
+    }
+
+    if (currentMapPointIndex_ == 0 && elapsedTime > segmentEndTime_)
+    {
+        // The stream ran out of points: hold the reached point
+        segmentStartPoint_ = segmentEndPoint_;
+        currentMapPointIndex_ = 1;
+        if (!stream->closed_)
+            stream->underruns_++;
+    }
+
+    // A held point is polled for new stream points on every spin update
+    if (currentMapPointIndex_ == 1)
+        segmentStartTime_ = segmentEndTime_ = elapsedTime;
+}
+
+/**
+ * Makes the loaded map segment the current one
+ * @note Segment times and slope are only calculated here, so they don't cost anything
+ *  in the spin updates done inside the segment
+ */
+void Spinner::enterSegment_()
+{
+    if (mapStorage_ != kStream && mapStorage_ != kProfile)
+        segmentStartTime_ = (unsigned long)segmentStartPoint_.time * timebase_;
+
+    // The last map point doesn't start any segment: it lasts forever
+    if (currentMapPointIndex_ >= mapSize_ - 1)
+    {
+        if (mapStorage_ != kStream)
+            segmentEndTime_ = 0xFFFFFFFF;
+        segmentCurve_ = Linear;
+        slope_[0] = slope_[1] = slope_[2] = slope_[3] = 0;
+        slopeDescending_ = false;
+        return;
+    }
+    if (mapStorage_ != kStream && mapStorage_ != kProfile)
+        segmentEndTime_ = (unsigned long)segmentEndPoint_.time * timebase_;
+
+    // The segment progress starts at one half
+    progress_[0] = progress_[1] = progress_[3] = 0;
+    progress_[2] = 0x8000;
+    progressTime_ = 0;
+
+    if (mapStorage_ == kCompiledMap)
+    {
+        // Compiled maps store the segment curve and slope
+        const CompiledSpinSegment *segment = (const CompiledSpinSegment *)map_ + currentMapPointIndex_;
+        segmentCurve_ = segment->curve;
+        slopeDescending_ = segment->descending;
+        for (uint8_t limb = 0; limb < 4; limb++)
+            slope_[limb] = segment->slope[limb];
+        return;
+    }
+
+    segmentCurve_ = Linear;
+    if (curves_ != NULL)
+    {
+        const uint8_t *curve = &curves_[currentMapPointIndex_];
+        segmentCurve_ = mapStorage_ == kFlashMap ? halReadFlashByte(curve) : *curve;
+    }
+
+#if defined(TB6612FNG_FLOAT_INTERPOLATION)
+    // Linear segments are interpolated with floating point math, without slope
+    if (segmentCurve_ == Linear)
+        return;
+#endif
+
+    slopeDescending_ = segmentEndPoint_.speed < segmentStartPoint_.speed;
+    getSlope_(segmentStartPoint_.speed, segmentEndPoint_.speed, segmentCurve_, segmentEndTime_ - segmentStartTime_, slope_);
+}
+
+/**
+ * Calculates the slope of a map segment
+ * @param {uint16_t} fromSpeed - Speed at the segment start
+ * @param {uint16_t} toSpeed - Speed at the segment end
+ * @param {uint8_t} curve - SpinCurve of the segment
+ * @param {unsigned long} timeIncrement - Segment duration, in timebase ticks
+ * @param {uint16_t[]} slope - Absolute speed increment (or, on curve segments, segment progress from 0 to 65535)
+ *  per timebase tick, in Q48 fixed point split in 16-bit limbs
+ */
+void Spinner::getSlope_(uint16_t fromSpeed, uint16_t toSpeed, uint8_t curve, unsigned long timeIncrement, uint16_t slope[])
+{
+    // Slope rounded up so that the interpolated speeds match those of the exact line equation.
+    // On curve segments, it's the slope of the segment progress, that is then shaped by the curve table
+    uint16_t speedIncrement = curve != Linear ? 0xFFFF : toSpeed < fromSpeed ? fromSpeed - toSpeed : toSpeed - fromSpeed;
+    for (uint8_t limb = 0; limb < 4; limb++)
+        slope[limb] = 0;
+
+    // A zero time increment is only reachable if the spin map integrity check is omitted
+    if (timeIncrement == 0)
+        return;
+
+    // The speed increment, shifted 48 bits, is divided with 32-bit math only: a 64-bit division takes
+    // thousands of cycles on 8-bit cores, where segments are entered from the SpinnerScheduler interrupt
+    uint32_t remainder = 0;
+    if (timeIncrement <= 0xFFFF)
+    {
+        // Long division by 16-bit limbs, whose partial dividends fit in 32 bits
+        for (int8_t limb = 3; limb >= 0; limb--)
+        {
+            uint32_t dividend = (remainder << 16) | (limb == 3 ? speedIncrement : 0);
+            slope[limb] = dividend / timeIncrement;
+            remainder = dividend % timeIncrement;
+        }
+    }
+    else
+    {
+        // Bit by bit long division. The speed increment is lower than the time increment,
+        // so the slope integer part is zero and only its 48 fraction bits are calculated
+        remainder = speedIncrement;
+        uint32_t quotientLow = 0;
+        uint16_t quotientHigh = 0;
+        for (uint8_t bit = 0; bit < 48; bit++)
+        {
+            bool carry = remainder >> 31;
+            remainder <<= 1;
+            quotientHigh = (quotientHigh << 1) | (quotientLow >> 31);
+            quotientLow <<= 1;
+            if (carry || remainder >= timeIncrement)
+            {
+                remainder -= timeIncrement;
+                quotientLow |= 1;
+            }
+        }
+        slope[0] = (uint16_t)quotientLow;
+        slope[1] = (uint16_t)(quotientLow >> 16);
+        slope[2] = quotientHigh;
+    }
+
+    // Round the slope up if the division isn't exact
+    if (remainder != 0)
+    {
+        for (uint8_t limb = 0; limb < 4; limb++)
+        {
+            if (++slope[limb] != 0)
+                break;
+        }
+    }
+}
+
+/**
+ * Returns the spin speed at a given elapsed time within the current map segment
+ * @param {unsigned long} elapsedTime - Elapsed time, in timebase ticks, since the spin start
+ * @param {bool} advance - True to advance the segment progress up to the elapsed time, false to keep it
+ * @returns {uint16_t} Spin speed
+ * @note When advancing the progress to the tick following that of the previous advance,
+ *  the segment slope is just added to it. Otherwise the progress is calculated by multiplying the slope
+ */
+uint16_t Spinner::getSpeed_(unsigned long elapsedTime, bool advance)
+{
+    // The spin is beyond the latest map point: the operation is finished
+    // and the current speed is the latest map point speed
+    if (currentMapPointIndex_ == mapSize_ - 1)
+        return segmentStartPoint_.speed;
+
+#if defined(TB6612FNG_FLOAT_INTERPOLATION)
+    if (segmentCurve_ == Linear)
+    {
+        return getLinePointY_(segmentStartTime_,
+                              segmentStartPoint_.speed,
+                              segmentEndTime_,
+                              segmentEndPoint_.speed,
+                              elapsedTime - segmentStartTime_);
+    }
+#endif
+
+    // The spin is between two map poins: Get the segment progress at the elapsed time
+    uint16_t segmentProgress[4];
+    uint16_t *progress = advance ? progress_ : segmentProgress;
+    unsigned long segmentTime = elapsedTime - segmentStartTime_;
+    if (advance && segmentTime == progressTime_ + 1)
+        addQ48_(progress_, slope_);
+    else
+        mulQ48_(segmentTime, slope_, progress);
+    if (advance)
+        progressTime_ = segmentTime;
+
+    // Get the intermediate point speed from the progress integer part
+#if defined(TB6612FNG_FLOAT_INTERPOLATION)
+    return getCurvePointY_(segmentStartPoint_.speed, segmentEndPoint_.speed, progress[3]);
+#else
+    if (segmentCurve_ != Linear)
+        return getCurvePointY_(segmentStartPoint_.speed, segmentEndPoint_.speed, progress[3]);
+    return getLinePointY_(segmentStartPoint_.speed, progress[3]);
+#endif
+}
+
+#if defined(TB6612FNG_FLOAT_INTERPOLATION)
 /**
  * Returns the Y coordinate of a point in a line given its X coordinate
- * @param {uint16_t} x1 - X coordinate of the line point 1
+ * @param {unsigned long} x1 - X coordinate of the line point 1
  * @param {uint16_t} y1 - Y coordinate of the line point 1
- * @param {uint16_t} x2 - X coordinate of the line point 2
+ * @param {unsigned long} x2 - X coordinate of the line point 2
  * @param {uint16_t} y2 - Y coordinate of the line point 2
- * @param {uint16_t} x - X coordinate of the line point whose Y coordinate must be obtained
+ * @param {unsigned long} x - X coordinate of the line point whose Y coordinate must be obtained
  * @return {uint16_t} Y coordinate of the line point with X coordinate equal to x
  */
-uint16_t Spinner::getLinePointY_(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t x)
+uint16_t Spinner::getLinePointY_(unsigned long x1, uint16_t y1, unsigned long x2, uint16_t y2, unsigned long x)
 {
+    // Division, multiplication and rounding
+    HAL_COUNT_FLOAT_OPS(3);
     return y1 + round(((double)x / (x2 - x1)) * (y2 - y1));
-}
\ No newline at end of file
+}
+#else
+/**
+ * Returns the speed of the current map segment given its progress
+ * @param {uint16_t} y1 - Speed at the segment start
+ * @param {uint16_t} increment - Segment progress, ie, absolute speed increment since the segment start
+ * @return {uint16_t} Segment speed
+ */
+uint16_t Spinner::getLinePointY_(uint16_t y1, uint16_t increment)
+{
+    return slopeDescending_ ? y1 - increment : y1 + increment;
+}
+#endif
+
+/**
+ * Returns the speed of the current curve map segment given its progress
+ * @param {uint16_t} y1 - Speed at the segment start
+ * @param {uint16_t} y2 - Speed at the segment end
+ * @param {uint16_t} progress - Segment progress, from 0 to 65535
+ * @return {uint16_t} Segment speed
+ * @note The curve shape is linearly interpolated between the curve table samples, with integer math only
+ */
+uint16_t Spinner::getCurvePointY_(uint16_t y1, uint16_t y2, uint16_t progress)
+{
+    // Segment progress split in curve table sample and fraction between samples
+    uint8_t sample = progress >> (16 - kCurveTableBits);
+    uint16_t fraction = progress & ((1 << (16 - kCurveTableBits)) - 1);
+
+    const uint16_t *table = segmentCurve_ == SCurve ? kSCurveTable : kExponentialTable;
+    uint16_t shape0 = halReadFlashWord(&table[sample]);
+    uint16_t shape1 = halReadFlashWord(&table[sample + 1]);
+    uint16_t shape = shape0 + (((uint32_t)(shape1 - shape0) * fraction) >> (16 - kCurveTableBits));
+
+    // Curve tables are increasing, so the speed increment is the shaped absolute speed increment
+    uint16_t speedIncrement = slopeDescending_ ? y1 - y2 : y2 - y1;
+    uint16_t increment = ((uint32_t)speedIncrement * shape + 0x8000) >> 16;
+    return slopeDescending_ ? y1 - increment : y1 + increment;
+}
+
+/**
+ * Multiplies an integer by a Q48 fixed point value, rounding the product
+ * @param {unsigned long} x - Integer multiplicand
+ * @param {uint16_t[]} q48 - Q48 fixed point multiplier, split in four 16-bit limbs (least significant first)
+ * @param {uint16_t[]} product - Product plus one half, in Q48 fixed point split in four 16-bit limbs.
+ *  Its integer part, the limb 3, is the product rounded half up
+ * @note The product is computed with 16-bit partial products, cheap on 8-bit cores,
+ *  and its integer part must fit in 16 bits
+ */
+void Spinner::mulQ48_(unsigned long x, const uint16_t q48[], uint16_t product[])
+{
+    product[0] = product[1] = product[3] = 0;
+    product[2] = 0x8000;
+
+    // Product limbs, accumulated from the partial products of every multiplicand limb
+    uint16_t xLimbs[2] = {(uint16_t)x, (uint16_t)(x >> 16)};
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        // The high multiplicand limb is zero on millisecond timebase
+        if (xLimbs[i] == 0)
+            continue;
+
+        uint32_t carry = 0;
+        for (uint8_t j = 0; i + j < 4; j++)
+        {
+            uint32_t partial = (uint32_t)xLimbs[i] * q48[j] + product[i + j] + carry;
+            product[i + j] = (uint16_t)partial;
+            carry = partial >> 16;
+        }
+    }
+}
+
+/**
+ * Adds a Q48 fixed point value to another one
+ * @param {uint16_t[]} q48 - Q48 fixed point augend, split in four 16-bit limbs, replaced by the sum
+ * @param {uint16_t[]} addend - Q48 fixed point addend, split in four 16-bit limbs
+ */
+void Spinner::addQ48_(uint16_t q48[], const uint16_t addend[])
+{
+    uint16_t carry = 0;
+    for (uint8_t limb = 0; limb < 4; limb++)
+    {
+        uint32_t sum = (uint32_t)q48[limb] + addend[limb] + carry;
+        q48[limb] = (uint16_t)sum;
+        carry = sum >> 16;
+    }
+}
+
+#if defined(TB6612FNG_SPIN_STATS)
+/**
+ * Records the interval between two spin() calls in the timing statistics
+ * @param {unsigned long} interval - Interval, in timebase ticks
+ */
+void Spinner::recordInterval_(unsigned long interval)
+{
+    stats_.calls++;
+    stats_.intervalSum += interval;
+    if (interval < stats_.minInterval)
+        stats_.minInterval = interval;
+    if (interval > stats_.maxInterval)
+        stats_.maxInterval = interval;
+
+    // Log2 bin: the number of significant bits of the interval
+    uint8_t bin = 0;
+    while (interval != 0 && bin < SPIN_STATS_BINS - 1)
+    {
+        interval >>= 1;
+        bin++;
+    }
+    if (stats_.intervalHistogram[bin] < 0xFFFF)
+        stats_.intervalHistogram[bin]++;
+}
+#endif
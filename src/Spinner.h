@@ -8,6 +8,10 @@
 
 #include "Motor.h"
 
+class SpinStream;
+class CompiledSpinMap;
+class SpinProfile;
+
 /**
  * Spin point
  * @typedef {struct} SpinPoint
@@ -21,12 +25,106 @@ struct SpinPoint
     uint16_t time;
 };
 
+/**
+ * Signed spin point, for spin maps whose speed changes its sign, ie, reversing the motor rotation
+ * @typedef {struct} SignedSpinPoint
+ * @property {int16_t} velocity - Spin velocity, from -32767 (100% in reverse direction) to 32767 (100% in forward direction)
+ * @property {uint16_t} time - Elapsed time from the spin start, from 0 to 65535 milliseconds, in which velocity must be reached
+ * @example The map {{16384, 0}, {-16384, 1000}} reverses a motor spinning at 50% to 50% in the opposite direction in a second
+ */
+struct SignedSpinPoint
+{
+    int16_t velocity;
+    uint16_t time;
+};
+
+/**
+ * Packed spin map encoding, for maps stored in flash memory and started with Spinner::startPacked().
+ * A packed map is a byte array starting with the first map point speed (its time is always zero)
+ * followed by every other map point, encoded as its time and speed increments since the previous point:
+ * with two bytes if the time increment is lower than 256ms and the speed increment is in the range -128 to 127,
+ * else with five bytes holding the time increment and the absolute speed
+ * @example const uint8_t packedMap[] PROGMEM = {SPIN_PACKED_START(1000), SPIN_PACKED_DELTA(10, 100), SPIN_PACKED_POINT(5000, 0)};
+ */
+#define SPIN_PACKED_START(speed) (uint8_t)(speed), (uint8_t)((speed) >> 8)
+#define SPIN_PACKED_DELTA(timeIncrement, speedIncrement) (uint8_t)(timeIncrement), (uint8_t)(int8_t)(speedIncrement)
+#define SPIN_PACKED_POINT(timeIncrement, speed) 0, (uint8_t)(timeIncrement), (uint8_t)((timeIncrement) >> 8), (uint8_t)(speed), (uint8_t)((speed) >> 8)
+
+/**
+ * Spinner timebases, valued as the timebase ticks per millisecond
+ * @enum
+ */
+enum SpinTimebase
+{
+    Milliseconds = 1,
+    Microseconds = 1000
+};
+
+/**
+ * Motor outputs set at zero speed
+ * @enum
+ */
+enum ZeroSpeedMode
+{
+    Coast = 0,
+    Brake = 1
+};
+
+/**
+ * Spin map segment curves, ie, the way the speed changes between two spin points
+ * @enum
+ * @note Curve arrays are declared as uint8_t arrays holding a curve per map segment
+ */
+enum SpinCurve
+{
+    Linear = 0,
+    SCurve = 1,
+    Exponential = 2
+};
+
+#if defined(TB6612FNG_SPIN_STATS)
+/**
+ * Number of bins of the spin call interval histogram
+ */
+#define SPIN_STATS_BINS 16
+
+/**
+ * Spinner timing statistics, collected when the library is built with the symbol TB6612FNG_SPIN_STATS defined
+ * @typedef {struct} SpinStats
+ * @property {unsigned long} calls - Calls to spin() done while spinning
+ * @property {unsigned long} minInterval - Shortest interval between spin() calls, in timebase ticks
+ * @property {unsigned long} maxInterval - Longest interval between spin() calls, in timebase ticks
+ * @property {unsigned long} intervalSum - Sum of the intervals between spin() calls, in timebase ticks. The average interval is intervalSum / calls
+ * @property {uint16_t[]} intervalHistogram - Calls per interval, in log2 bins: bin 0 counts the zero intervals and bin n the intervals from 2^(n-1) to 2^n - 1 ticks. The last bin counts every longer interval. The counts saturate at 65535
+ * @property {unsigned long} skippedSteps - Late calls, ie, calls setting a speed that skips some intermediate speed due to the time elapsed since the previous call
+ * @property {unsigned long} spinTime - Time spent inside spin(), excluding the callbacks, in microseconds
+ * @property {unsigned long} callbackTime - Time spent inside the callback functions, in microseconds
+ */
+struct SpinStats
+{
+    unsigned long calls;
+    unsigned long minInterval;
+    unsigned long maxInterval;
+    unsigned long intervalSum;
+    uint16_t intervalHistogram[SPIN_STATS_BINS];
+    unsigned long skippedSteps;
+    unsigned long spinTime;
+    unsigned long callbackTime;
+};
+#endif
+
 /**
  * Spinner callback type
  * @typedef {(*)(const SpinPoint *)} SpinnerCB
  */
 typedef void (*SpinnerCB)(const SpinPoint *);
 
+/**
+ * Spinner callback type receiving a user context
+ * @typedef {(*)(void *, const SpinPoint *)} SpinnerContextCB
+ */
+typedef void (*SpinnerContextCB)(void *, const SpinPoint *);
+
 /**
  * Controller for Toshiba TB6612FNG driven motors supporting acceleration/deleration features
  * @class
@@ -37,18 +135,28 @@ public:
     /**
      * Creates an acceleration/deceleration controller for TB6612FNG driven motors
      * @constructor
-     * @param {Motor*} motor - Pointer to a Motor object instance
+     * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
      */
-    Spinner(Motor *motor);
+    Spinner(MotorInterface *motor);
 
     /**
      * Creates an acceleration/deceleration controller for TB6612FNG driven motors and use callbacks for handling its events
      * @constructor
-     * @param {Motor*} motor - Pointer to a Motor object instance
+     * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
      * @param {SpinnerCB} spinUpdated -Callback function for handling the spin updated event
      * @param {SpinnerCB} spinFinished - Callback function for handling the spin finished event
      */
-    Spinner(Motor *motor, SpinnerCB spinUpdated, SpinnerCB spinFinished);
+    Spinner(MotorInterface *motor, SpinnerCB spinUpdated, SpinnerCB spinFinished);
+
+    /**
+     * Creates an acceleration/deceleration controller for TB6612FNG driven motors and use callbacks receiving a user context for handling its events
+     * @constructor
+     * @param {MotorInterface*} motor - Pointer to a Motor (or StaticMotor) object instance
+     * @param {SpinnerContextCB} spinUpdated - Callback function for handling the spin updated event
+     * @param {SpinnerContextCB} spinFinished - Callback function for handling the spin finished event
+     * @param {void*} context - User context passed to the callbacks, so several spinners can share them
+     */
+    Spinner(MotorInterface *motor, SpinnerContextCB spinUpdated, SpinnerContextCB spinFinished, void *context);
 
     /**
      * Starts a motor lineal acceleration/deceleration defined by a map with only two points
@@ -69,38 +177,310 @@ public:
      */
     const SpinPoint *start(Direction direction, SpinPoint spinMap[], uint8_t spinMapSize);
 
+    /**
+     * Starts a motor acceleration/deceleration defined by a map with multiple points and the curves of its segments
+     * @param {Direction} direction - Motor rotation direction
+     * @param {SpinPoint[]} spinMap - Spin map containing a list of spin points
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, ie, spinMapSize - 1 curves
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[]);
+
+    /**
+     * Starts a motor lineal acceleration/deceleration defined by a map with signed speeds
+     * @param {Direction} direction - Motor rotation direction of the positive velocities
+     * @param {SignedSpinPoint[]} spinMap - Spin map containing a list of signed spin points
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note The spin points returned and passed to the callbacks hold the signed velocity in their speed,
+     *  so they can be read as SignedSpinPoint structs
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, SignedSpinPoint spinMap[], uint8_t spinMapSize);
+
+    /**
+     * Starts a motor acceleration/deceleration defined by a map with signed speeds and the curves of its segments
+     * @param {Direction} direction - Motor rotation direction of the positive velocities
+     * @param {SignedSpinPoint[]} spinMap - Spin map containing a list of signed spin points
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, ie, spinMapSize - 1 curves
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, SignedSpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[]);
+
+    /**
+     * Starts a motor lineal acceleration/deceleration defined by a map stored in flash memory
+     * @param {Direction} direction - Motor rotation direction
+     * @param {const SpinPoint[]} spinMap - Spin map containing a list of spin points, declared with PROGMEM
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note The map is read from flash one segment at a time, so it doesn't take any RAM
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *startFlash(Direction direction, const SpinPoint spinMap[], uint8_t spinMapSize);
+
+    /**
+     * Starts a motor acceleration/deceleration defined by a map and the curves of its segments stored in flash memory
+     * @param {Direction} direction - Motor rotation direction
+     * @param {const SpinPoint[]} spinMap - Spin map containing a list of spin points, declared with PROGMEM
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @param {const uint8_t[]} segmentCurves - SpinCurve of every map segment, ie, spinMapSize - 1 curves, declared with PROGMEM
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *startFlash(Direction direction, const SpinPoint spinMap[], uint8_t spinMapSize, const uint8_t segmentCurves[]);
+
+    /**
+     * Starts a motor lineal acceleration/deceleration defined by a packed map stored in flash memory
+     * @param {Direction} direction - Motor rotation direction
+     * @param {const uint8_t[]} packedSpinMap - Spin map encoded as explained in SPIN_PACKED_START, declared with PROGMEM
+     * @param {uint8_t} spinMapSize - Number of spin points contained in the spin map
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the start operation cannot be executed
+     * @note The map is decoded from flash one segment at a time, so it doesn't take any RAM
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *startPacked(Direction direction, const uint8_t packedSpinMap[], uint8_t spinMapSize);
+
+    /**
+     * Starts a motor lineal acceleration/deceleration defined by the points of a stream
+     * @param {Direction} direction - Motor rotation direction
+     * @param {SpinStream*} spinStream - Stream storing at least the first spin point. Further points can be appended while spinning
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first stream point or null if the stream is empty
+     * @note The spin finishes when the last point of a closed stream is reached
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, SpinStream *spinStream);
+
+    /**
+     * Starts a motor acceleration/deceleration defined by a compiled spin map
+     * @param {Direction} direction - Motor rotation direction
+     * @param {CompiledSpinMap*} compiledSpinMap - Spin map compiled for the spinner timebase
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first spin map point or null if the map is not compiled or it was compiled for another timebase
+     * @note Compiled maps are spun without divisions, and the spin updates done on consecutive timebase ticks only add the segment slope
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, CompiledSpinMap *compiledSpinMap);
+
+    /**
+     * Starts a motor acceleration/deceleration defined by a spin profile
+     * @param {Direction} direction - Motor rotation direction
+     * @param {SpinProfile*} spinProfile - Spin profile, with 32-bit point times and optionally looping
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the first profile point or null if the start operation cannot be executed
+     * @note The spin point times returned and passed to the callbacks are the profile times, in milliseconds, truncated to 16 bits
+     * @note Starting a spin operation will abort a previous running spinning operation
+     */
+    const SpinPoint *start(Direction direction, SpinProfile *spinProfile);
+
     /**
      * Updates a running spin operation
      * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the last reached spin map point, or null if no spin operation is in progress.
-     * @note This function must be called periodically. To achieve a smooth spin, a call periodicity lower or equal to 1 millisecond is recommended.
+     * @note This function must be called periodically. To achieve a smooth spin, a call periodicity lower or equal to 1 millisecond (or to the desired update period on microseconds timebase) is recommended.
      */
     const SpinPoint *spin();
 
+    /**
+     * Updates a running spin operation at a given time
+     * @param {unsigned long} time - Current time in timebase ticks (milliseconds or microseconds), as returned by millis() or micros()
+     * @returns {const SpinPoint*} Pointer to a constant SpinPoint struct containing the last reached spin map point, or null if no spin operation is in progress.
+     * @note Allows updating several spinners with a single clock read
+     */
+    const SpinPoint *spin(unsigned long time);
+
+    /**
+     * Gets the time at which the next spin update is due, ie, the earliest time the spin speed will change
+     * @param {unsigned long*} dueTime - Due time in timebase ticks (milliseconds or microseconds), as returned by millis() or micros()
+     * @returns {bool} True if the due time was got, false if no spin operation is in progress
+     * @note Calling spin() before the due time doesn't change anything, so the program can sleep or do other work until then
+     */
+    bool nextUpdateDue(unsigned long *dueTime);
+
     /**
      * Aborts a spin operation, keeping the motor rotating at the last speed reached by the aborted spin operation.
      * @returns Pointer to a SpinPoint struct containing the last reached spin map point, or null if no spin operation was aborted.
      */
     const SpinPoint *abort();
 
+    /**
+     * Sets the timebase used for calculating the spin speeds
+     * @param {SpinTimebase} timebase - Timebase. Milliseconds by default
+     * @note With a microseconds timebase, the speed can be updated several times per millisecond
+     * @note Setting the timebase will abort a running spinning operation
+     */
+    void timebase(SpinTimebase timebase);
+
+    /**
+     * Returns the timebase used for calculating the spin speeds
+     * @returns {SpinTimebase} Timebase
+     */
+    SpinTimebase timebase();
+
+    /**
+     * Sets the motor outputs at zero speed, and the dwell of the motor at zero speed when a signed map reverses it
+     * @param {ZeroSpeedMode} mode - Coast (default) to stop the motor, Brake to short-brake it
+     * @param {uint16_t} reversalDwell - Milliseconds the motor is kept at zero speed after every zero crossing of a signed map, 0 by default
+     * @note The dwell doesn't delay the spin map: the map speeds reached during the dwell are just not set
+     */
+    void zeroSpeed(ZeroSpeedMode mode, uint16_t reversalDwell);
+
+    /**
+     * Decimates the spin updated events, raising them only after a given time or speed change
+     * @param {uint16_t} minInterval - Milliseconds from the last raised event, 0 by default
+     * @param {uint16_t} minSpeedDelta - Speed change from the last raised event, 0 by default
+     * @note An event is raised once both are reached. The first update of a spin operation always raises it,
+     *  and the spin finished event reports the final speed
+     */
+    void updateFilter(uint16_t minInterval, uint16_t minSpeedDelta);
+
+#if defined(TB6612FNG_SPIN_STATS)
+    /**
+     * Gets the timing statistics collected since the spinner creation or the last statistics reset
+     * @param {SpinStats*} stats - Struct the statistics are copied to
+     */
+    void stats(SpinStats *stats);
+
+    /**
+     * Resets the timing statistics
+     */
+    void resetStats();
+#endif
+
 private:
-    Motor *motor_;
+    friend class SpinnerScheduler;
+    friend class SpinnerGroup;
+    friend class CompiledSpinMap;
 
-    SpinPoint *map_;
+    // Memory a spin map is read from
+    enum MapStorage
+    {
+        kRamMap,
+        kFlashMap,
+        kPackedMap,
+        kStream,
+        kCompiledMap,
+        kSignedMap,
+        kProfile
+    };
+
+    MotorInterface *motor_;
+
+    const void *map_;
+    MapStorage mapStorage_;
     uint8_t mapSize_;
+    const uint8_t *curves_;
 
     Direction spinDirection_;
+    SpinTimebase timebase_;
     unsigned long spinStartTime_;
+    unsigned long spinElapsedTime_;
     SpinPoint currentSpinPoint_;
 
+    // Map segment starting at the last reached map point, with its start and end points
+    // and its start and end times in timebase ticks since the spin start.
+    // Streams are spun as two points maps: the segment to the next stream point (index 0),
+    // or the reached point held until a new point is appended (index 1)
     uint8_t currentMapPointIndex_;
+    SpinPoint segmentStartPoint_, segmentEndPoint_;
+    uint8_t segmentCurve_;
+    unsigned long segmentStartTime_;
+    unsigned long segmentEndTime_;
+
+    // Slope of the current map segment, as absolute speed increment (or, on curve segments,
+    // segment progress from 0 to 65535) per timebase tick in Q48 fixed point, split in 16-bit limbs
+    uint16_t slope_[4];
+    bool slopeDescending_;
+
+    // Segment progress, ie, the slope times the timebase ticks since the segment start plus
+    // one half (so that its integer part is rounded), and the ticks it was calculated for.
+    // Spin updates done on consecutive ticks advance it by adding the slope
+    uint16_t progress_[4];
+    unsigned long progressTime_;
 
+    // Signed maps are spun as maps whose speeds are offset by 32768, so that they're unsigned.
+    // Speeds are exposed in two's complement instead, flipping their sign bit with this mask
+    uint16_t speedMask_;
+
+    // Zero speed outputs, and reversal dwell of signed maps: sign of the last velocity set
+    // and elapsed time, in timebase ticks, until which a zero crossing keeps the motor at zero speed
+    ZeroSpeedMode zeroSpeedMode_;
+    uint16_t reversalDwell_;
+    int8_t outputSign_;
+    bool dwelling_;
+    unsigned long dwellEndTime_;
+
+    // Looping profiles: loop backs left, time of the last profile point and loop cycle duration, in timebase ticks
+    uint16_t loopsLeft_;
+    unsigned long profileEndTime_;
+    unsigned long loopDuration_;
+
+    // Packed maps are decoded forward: encoding of the point following the segment end point
+    const uint8_t *packedCursor_;
+
+    // Callbacks are either plain or receiving the user context
     SpinnerCB spinUpdatedCB_, spinFinishedCB_;
+    SpinnerContextCB spinUpdatedContextCB_, spinFinishedContextCB_;
+    void *context_;
+
+    // Spin updated event decimation: thresholds and the last point raising the event
+    uint16_t updateMinInterval_;
+    uint16_t updateMinSpeedDelta_;
+    bool updateRaised_;
+    SpinPoint raisedUpdatePoint_;
+
+    // Scheduled spinners are spun from an interrupt service routine,
+    // so their callbacks are deferred as pending events dispatched from the main loop
+    bool scheduled_;
+    volatile uint8_t pendingEvents_;
+    SpinPoint pendingUpdatedPoint_, pendingFinishedPoint_;
+
+    // Grouped spinners defer their callbacks and motor outputs too, so that their group
+    // applies the outputs of all its members back-to-back before calling any callback
+    bool grouped_;
+    bool outputPending_;
+
+#if defined(TB6612FNG_SPIN_STATS)
+    SpinStats stats_;
+#endif
 
-    bool checkSpinMap_(SpinPoint[], uint8_t);
-    unsigned long getElapsedTime_(unsigned long);
-    void updateSpeed_(Motor *, Direction, SpinPoint *, SpinnerCB);
-    uint8_t refreshSpinCourse_(SpinPoint *, uint8_t, unsigned long);
-    uint16_t getLinePointY_(uint16_t, uint16_t, uint16_t, uint16_t, uint16_t);
+    const SpinPoint *start_(Direction, const void *, MapStorage, uint8_t, const uint8_t *);
+    static bool checkSpinMap_(const void *, MapStorage, uint8_t, const uint8_t *);
+    static void readMapPoint_(const void *, MapStorage, uint8_t, SpinPoint *);
+    static unsigned long getPointTime_(const void *, MapStorage, uint8_t, uint16_t);
+    static bool decodePackedPoint_(const uint8_t **, SpinPoint *);
+    const SpinPoint *spin_(unsigned long);
+    unsigned long getTime_();
+    unsigned long getMillis_(unsigned long);
+    unsigned long getElapsedTime_(unsigned long, unsigned long);
+    void updateSpeed_(MotorInterface *, Direction, SpinPoint *);
+    void writeSpeed_(MotorInterface *, Direction, uint16_t);
+    bool updateReversal_(uint16_t, unsigned long);
+    void applyOutput_();
+    bool filterUpdate_(const SpinPoint *);
+    bool hasCallback_(uint8_t);
+    void raiseEvent_(SpinPoint *, uint8_t);
+    void callback_(uint8_t, const SpinPoint *);
+    void dispatchEvents_();
+    uint8_t refreshSpinCourse_(const void *, MapStorage, uint8_t, uint8_t, unsigned long, uint16_t);
+    void loadSegment_(uint8_t);
+    unsigned long loopProfile_(unsigned long);
+    void advanceSegment_();
+    void advanceStream_(unsigned long);
+    void enterSegment_();
+    uint16_t getSpeed_(unsigned long, bool);
+    static void getSlope_(uint16_t, uint16_t, uint8_t, unsigned long, uint16_t[]);
+#if defined(TB6612FNG_SPIN_STATS)
+    void recordInterval_(unsigned long);
+#endif
+#if defined(TB6612FNG_FLOAT_INTERPOLATION)
+    uint16_t getLinePointY_(unsigned long, uint16_t, unsigned long, uint16_t, unsigned long);
+#else
+    uint16_t getLinePointY_(uint16_t, uint16_t);
+#endif
+    uint16_t getCurvePointY_(uint16_t, uint16_t, uint16_t);
+    static void mulQ48_(unsigned long, const uint16_t[], uint16_t[]);
+    static void addQ48_(uint16_t[], const uint16_t[]);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+// SpinnerGroup.cpp
+// Implementation of the SpinnerGroup class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "SpinnerGroup.h"
+
+// Public functions definition
+
+/**
+ * Creates a group of spinners using a milliseconds timebase
+ * @constructor
+ */
+SpinnerGroup::SpinnerGroup() : SpinnerGroup(Milliseconds, NULL){};
+
+/**
+ * Creates a group of spinners using a given timebase and a callback for handling its finished event
+ * @constructor
+ * @param {SpinTimebase} timebase - Timebase of the grouped spinners
+ * @param {SpinnerGroupCB} groupFinished - Callback function for handling the group finished event, or null
+ */
+SpinnerGroup::SpinnerGroup(SpinTimebase timebase, SpinnerGroupCB groupFinished) : timebase_(timebase), groupFinishedCB_(groupFinished)
+{
+    spinnersCount_ = 0;
+    running_ = false;
+}
+
+/**
+ * Adds a spinner to the group
+ * @param {Spinner*} spinner - Pointer to a Spinner object instance
+ * @returns {bool} True if the spinner was added, false if the group is full or the spinner is scheduled
+ */
+bool SpinnerGroup::add(Spinner *spinner)
+{
+    // Scheduled spinners are spun by their scheduler
+    if (spinnersCount_ == TB6612FNG_GROUP_CAPACITY || spinner->scheduled_)
+        return false;
+
+    // Every grouped spinner is spun with the same clock read
+    spinner->timebase(timebase_);
+    spinner->grouped_ = true;
+    spinners_[spinnersCount_] = spinner;
+    spinnersCount_++;
+
+    return true;
+}
+
+/**
+ * Removes a spinner from the group
+ * @param {Spinner*} spinner - Pointer to a previously added Spinner object instance
+ * @returns {bool} True if the spinner was removed, false if it wasn't added
+ */
+bool SpinnerGroup::remove(Spinner *spinner)
+{
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+    {
+        if (spinners_[i] != spinner)
+            continue;
+
+        for (uint8_t j = i + 1; j < spinnersCount_; j++)
+            spinners_[j - 1] = spinners_[j];
+        spinnersCount_--;
+
+        spinner->applyOutput_();
+        spinner->dispatchEvents_();
+        spinner->grouped_ = false;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Starts the spin operations of the grouped spinners at the same time
+ * @returns {bool} True if any grouped spinner is spinning, else false
+ */
+bool SpinnerGroup::start()
+{
+    // Shared epoch: the spins started by the spinners are moved to a single clock read
+    unsigned long epoch = timebase_ == Milliseconds ? halMillis() : halMicros();
+    running_ = false;
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+    {
+        Spinner *spinner = spinners_[i];
+        if (spinner->map_ == NULL)
+            continue;
+
+        spinner->spinStartTime_ = epoch;
+        running_ = true;
+    }
+
+    applyOutputs_();
+    return running_;
+}
+
+/**
+ * Updates the spin operations of the grouped spinners
+ * @returns {bool} True if any grouped spinner is still spinning, else false
+ */
+bool SpinnerGroup::spin()
+{
+    return spin(timebase_ == Milliseconds ? halMillis() : halMicros());
+}
+
+/**
+ * Updates the spin operations of the grouped spinners at a given time
+ * @param {unsigned long} time - Current time in timebase ticks
+ * @returns {bool} True if any grouped spinner is still spinning, else false
+ */
+bool SpinnerGroup::spin(unsigned long time)
+{
+    // Calculate every speed first, so that the motor outputs are then applied
+    // without any calculation between them
+    bool spinning = false;
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+    {
+        spinners_[i]->spin(time);
+        spinning |= spinners_[i]->map_ != NULL;
+    }
+
+    applyOutputs_();
+
+    // The group finishes once its last spinning member finishes
+    if (running_ && !spinning)
+    {
+        running_ = false;
+        if (groupFinishedCB_)
+            groupFinishedCB_();
+    }
+
+    return spinning;
+}
+
+/**
+ * Aborts the spin operations of the grouped spinners
+ */
+void SpinnerGroup::abort()
+{
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+        spinners_[i]->abort();
+    running_ = false;
+}
+
+// Private functions definition
+
+/**
+ * Applies the pending motor outputs of the grouped spinners back-to-back,
+ * and then calls the callbacks of their pending events
+ */
+void SpinnerGroup::applyOutputs_()
+{
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+        spinners_[i]->applyOutput_();
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+        spinners_[i]->dispatchEvents_();
+}
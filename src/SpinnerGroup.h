@@ -0,0 +1,97 @@
+// SpinnerGroup.h
+// Header file for SpinnerGroup class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SPINNER_GROUP_H
+#define SPINNER_GROUP_H
+
+#include "Spinner.h"
+
+#ifndef TB6612FNG_GROUP_CAPACITY
+#define TB6612FNG_GROUP_CAPACITY 4
+#endif
+
+/**
+ * Group finished event callback function
+ * @typedef {function} SpinnerGroupCB
+ */
+typedef void (*SpinnerGroupCB)();
+
+/**
+ * Group of spinners spun on a shared time reference, so that their motors stay in step
+ * @class
+ */
+class SpinnerGroup
+{
+public:
+    /**
+     * Creates a group of spinners using a milliseconds timebase
+     * @constructor
+     */
+    SpinnerGroup();
+
+    /**
+     * Creates a group of spinners using a given timebase and a callback for handling its finished event
+     * @constructor
+     * @param {SpinTimebase} timebase - Timebase of the grouped spinners
+     * @param {SpinnerGroupCB} groupFinished - Callback function for handling the group finished event, or null
+     */
+    SpinnerGroup(SpinTimebase timebase, SpinnerGroupCB groupFinished);
+
+    /**
+     * Adds a spinner to the group
+     * @param {Spinner*} spinner - Pointer to a Spinner object instance
+     * @returns {bool} True if the spinner was added, false if the group is full or the spinner is scheduled
+     * @note The spinner timebase is set to the group timebase, so a running spinning operation will be aborted
+     * @note From then on, the spinner must not be spun by calling its spin() function
+     */
+    bool add(Spinner *spinner);
+
+    /**
+     * Removes a spinner from the group
+     * @param {Spinner*} spinner - Pointer to a previously added Spinner object instance
+     * @returns {bool} True if the spinner was removed, false if it wasn't added
+     * @note The pending output and events of the spinner are applied before removing it
+     */
+    bool remove(Spinner *spinner);
+
+    /**
+     * Starts the spin operations of the grouped spinners at the same time
+     * @returns {bool} True if any grouped spinner is spinning, else false
+     * @note The spinners must be started by their start() functions first. This function sets a single
+     *  start time for all of them and then applies their start speeds back-to-back
+     */
+    bool start();
+
+    /**
+     * Updates the spin operations of the grouped spinners
+     * @returns {bool} True if any grouped spinner is still spinning, else false
+     */
+    bool spin();
+
+    /**
+     * Updates the spin operations of the grouped spinners at a given time
+     * @param {unsigned long} time - Current time in timebase ticks
+     * @returns {bool} True if any grouped spinner is still spinning, else false
+     */
+    bool spin(unsigned long time);
+
+    /**
+     * Aborts the spin operations of the grouped spinners
+     */
+    void abort();
+
+private:
+    SpinTimebase timebase_;
+    SpinnerGroupCB groupFinishedCB_;
+    Spinner *spinners_[TB6612FNG_GROUP_CAPACITY];
+    uint8_t spinnersCount_;
+
+    // True from the group start until every grouped spinner finished or the group is aborted
+    bool running_;
+
+    void applyOutputs_();
+};
+
+#endif
@@ -0,0 +1,114 @@
+// SpinnerScheduler.cpp
+// Implementation of the SpinnerScheduler class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "SpinnerScheduler.h"
+
+// Public functions definition
+
+/**
+ * Creates a scheduler for spinners using a milliseconds timebase
+ * @constructor
+ */
+SpinnerScheduler::SpinnerScheduler() : SpinnerScheduler(Milliseconds){};
+
+/**
+ * Creates a scheduler for spinners using a given timebase
+ * @constructor
+ * @param {SpinTimebase} timebase - Timebase of the scheduled spinners
+ */
+SpinnerScheduler::SpinnerScheduler(SpinTimebase timebase) : timebase_(timebase)
+{
+    spinnersCount_ = 0;
+}
+
+/**
+ * Adds a spinner to the scheduler
+ * @param {Spinner*} spinner - Pointer to a Spinner object instance
+ * @returns {bool} True if the spinner was added, false if the scheduler is full or the spinner is already scheduled or grouped
+ */
+bool SpinnerScheduler::add(Spinner *spinner)
+{
+    // A spinner is spun by a single scheduler or group, and only once per tick
+    if (spinnersCount_ == TB6612FNG_SCHEDULER_CAPACITY || spinner->scheduled_ || spinner->grouped_)
+        return false;
+
+    // Every scheduled spinner is spun with the same clock read
+    spinner->timebase(timebase_);
+    spinner->scheduled_ = true;
+
+    // Publish the spinner once it's fully set up
+    HalInterruptState interruptState = halDisableInterrupts();
+    spinners_[spinnersCount_] = spinner;
+    spinnersCount_++;
+    halRestoreInterrupts(interruptState);
+
+    return true;
+}
+
+/**
+ * Removes a spinner from the scheduler
+ * @param {Spinner*} spinner - Pointer to a previously added Spinner object instance
+ * @returns {bool} True if the spinner was removed, false if it wasn't added
+ */
+bool SpinnerScheduler::remove(Spinner *spinner)
+{
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+    {
+        if (spinners_[i] != spinner)
+            continue;
+
+        // Unpublish the spinner, keeping the scheduling order of the remaining ones
+        HalInterruptState interruptState = halDisableInterrupts();
+        for (uint8_t j = i + 1; j < spinnersCount_; j++)
+            spinners_[j - 1] = spinners_[j];
+        spinnersCount_--;
+        halRestoreInterrupts(interruptState);
+
+        spinner->dispatchEvents_();
+        spinner->scheduled_ = false;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Starts ticking the scheduler from a hardware timer interrupt
+ * @returns {bool} True if a hardware timer was set up, false if tick() must be called from a user timer
+ */
+bool SpinnerScheduler::begin()
+{
+#if defined(__AVR__)
+    // Timer0 already overflows about once per millisecond to keep millis():
+    // its compare A match happens once per count too, so enabling its interrupt
+    // adds a tick at the same rate. OCR0A is left untouched, since it sets the pin 6 PWM duty
+    HalInterruptState interruptState = halDisableInterrupts();
+    TIMSK0 |= _BV(OCIE0A);
+    halRestoreInterrupts(interruptState);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Spins every scheduled spinner
+ */
+void SpinnerScheduler::tick()
+{
+    // Single clock read for every spinner
+    unsigned long time = timebase_ == Milliseconds ? halMillis() : halMicros();
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+        spinners_[i]->spin(time);
+}
+
+/**
+ * Calls the callback functions of the events raised by the scheduled spinners since the previous dispatch
+ */
+void SpinnerScheduler::dispatch()
+{
+    for (uint8_t i = 0; i < spinnersCount_; i++)
+        spinners_[i]->dispatchEvents_();
+}
@@ -0,0 +1,93 @@
+// SpinnerScheduler.h
+// Header file for SpinnerScheduler class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SPINNER_SCHEDULER_H
+#define SPINNER_SCHEDULER_H
+
+#include "Spinner.h"
+
+#ifndef TB6612FNG_SCHEDULER_CAPACITY
+#define TB6612FNG_SCHEDULER_CAPACITY 8
+#endif
+
+/**
+ * Scheduler spinning several spinners from a periodic timer interrupt
+ * @class
+ */
+class SpinnerScheduler
+{
+public:
+    /**
+     * Creates a scheduler for spinners using a milliseconds timebase
+     * @constructor
+     */
+    SpinnerScheduler();
+
+    /**
+     * Creates a scheduler for spinners using a given timebase
+     * @constructor
+     * @param {SpinTimebase} timebase - Timebase of the scheduled spinners
+     */
+    SpinnerScheduler(SpinTimebase timebase);
+
+    /**
+     * Adds a spinner to the scheduler
+     * @param {Spinner*} spinner - Pointer to a Spinner object instance
+     * @returns {bool} True if the spinner was added, false if the scheduler is full or the spinner is already scheduled or grouped
+     * @note The spinner timebase is set to the scheduler timebase, so a running spinning operation will be aborted
+     * @note From then on, the spinner must not be spun by calling its spin() function
+     */
+    bool add(Spinner *spinner);
+
+    /**
+     * Removes a spinner from the scheduler
+     * @param {Spinner*} spinner - Pointer to a previously added Spinner object instance
+     * @returns {bool} True if the spinner was removed, false if it wasn't added
+     * @note The pending events of the spinner are dispatched before removing it
+     */
+    bool remove(Spinner *spinner);
+
+    /**
+     * Starts ticking the scheduler from a hardware timer interrupt
+     * @returns {bool} True if a hardware timer was set up, false if tick() must be called from a user timer
+     * @note On AVR processors the Timer0 compare A interrupt is used, ticking about once per millisecond
+     *  without changing millis() nor the PWM frequencies. The interrupt service routine must be defined
+     *  by placing the macro TB6612FNG_SCHEDULER_ISR(scheduler) in the sketch
+     */
+    bool begin();
+
+    /**
+     * Spins every scheduled spinner
+     * @note This function is addressed to be called from a periodic timer interrupt service routine.
+     *  The clock is read once per tick and the spinner callbacks are deferred until dispatch() is called
+     */
+    void tick();
+
+    /**
+     * Calls the callback functions of the events raised by the scheduled spinners since the previous dispatch
+     * @note This function must be called from the main loop. If several speed updates of a spinner
+     *  were raised since the previous dispatch, only the latest is dispatched
+     */
+    void dispatch();
+
+private:
+    SpinTimebase timebase_;
+    Spinner *spinners_[TB6612FNG_SCHEDULER_CAPACITY];
+    volatile uint8_t spinnersCount_;
+};
+
+#if defined(__AVR__)
+/**
+ * Defines the Timer0 compare A interrupt service routine ticking a scheduler
+ * @param {SpinnerScheduler} scheduler - Scheduler object instance
+ */
+#define TB6612FNG_SCHEDULER_ISR(scheduler) \
+    ISR(TIMER0_COMPA_vect)                 \
+    {                                      \
+        (scheduler).tick();                \
+    }
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+// StaticMotor.h
+// Header file for StaticMotor class template
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef STATIC_MOTOR_H
+#define STATIC_MOTOR_H
+
+#include "Motor.h"
+
+#if !defined(TB6612FNG_BENCHMARK) && !defined(TB6612FNG_PORTABLE_GPIO) && \
+    (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__))
+// Pins are resolved to ports and timer channels at compile time (Arduino Uno, Nano, Pro Mini)
+#define STATIC_MOTOR_AVR_PORTS
+
+/**
+ * Timer output compare channels driving the PWM pins
+ * @enum
+ */
+enum StaticPWMChannel
+{
+    kNoPWMChannel,
+    kOC0A,
+    kOC0B,
+    kOC1A,
+    kOC1B,
+    kOC2A,
+    kOC2B
+};
+
+/**
+ * Returns the port of an Arduino pin
+ * @param {pin_size_t} pin - Arduino pin
+ * @returns {char} Port letter ('B', 'C' or 'D'), or 0 if the pin doesn't exist
+ */
+constexpr char staticPinPort(pin_size_t pin)
+{
+    return pin < 8 ? 'D' : pin < 14 ? 'B' : pin < 20 ? 'C' : 0;
+}
+
+/**
+ * Returns the bit mask of an Arduino pin in its port registers
+ * @param {pin_size_t} pin - Arduino pin
+ * @returns {uint8_t} Bit mask
+ */
+constexpr uint8_t staticPinMask(pin_size_t pin)
+{
+    return 1 << (pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14);
+}
+
+/**
+ * Returns the timer output compare channel of an Arduino pin
+ * @param {pin_size_t} pin - Arduino pin
+ * @returns {StaticPWMChannel} Timer output compare channel, or kNoPWMChannel if the pin has no PWM feature
+ */
+constexpr StaticPWMChannel staticPinPWMChannel(pin_size_t pin)
+{
+    return pin == 3 ? kOC2B : pin == 5 ? kOC0B : pin == 6 ? kOC0A : pin == 9 ? kOC1A : pin == 10 ? kOC1B : pin == 11 ? kOC2A : kNoPWMChannel;
+}
+
+/**
+ * Registers of a port
+ * @class
+ */
+template <char port>
+struct StaticPort;
+
+template <>
+struct StaticPort<'B'>
+{
+    static volatile uint8_t &out() { return PORTB; }
+    static volatile uint8_t &ddr() { return DDRB; }
+};
+
+template <>
+struct StaticPort<'C'>
+{
+    static volatile uint8_t &out() { return PORTC; }
+    static volatile uint8_t &ddr() { return DDRC; }
+};
+
+template <>
+struct StaticPort<'D'>
+{
+    static volatile uint8_t &out() { return PORTD; }
+    static volatile uint8_t &ddr() { return DDRD; }
+};
+
+/**
+ * Registers of a timer output compare channel
+ * @class
+ * @note The timers are used as set up by the Arduino core, ie, 8-bit PWM
+ */
+template <StaticPWMChannel channel>
+struct StaticPWM;
+
+template <>
+struct StaticPWM<kOC0A>
+{
+    static volatile uint8_t &control() { return TCCR0A; }
+    static volatile uint8_t &compare() { return OCR0A; }
+    static const uint8_t kConnect = _BV(COM0A1);
+};
+
+template <>
+struct StaticPWM<kOC0B>
+{
+    static volatile uint8_t &control() { return TCCR0A; }
+    static volatile uint8_t &compare() { return OCR0B; }
+    static const uint8_t kConnect = _BV(COM0B1);
+};
+
+template <>
+struct StaticPWM<kOC1A>
+{
+    static volatile uint8_t &control() { return TCCR1A; }
+    static volatile uint16_t &compare() { return OCR1A; }
+    static const uint8_t kConnect = _BV(COM1A1);
+};
+
+template <>
+struct StaticPWM<kOC1B>
+{
+    static volatile uint8_t &control() { return TCCR1A; }
+    static volatile uint16_t &compare() { return OCR1B; }
+    static const uint8_t kConnect = _BV(COM1B1);
+};
+
+template <>
+struct StaticPWM<kOC2A>
+{
+    static volatile uint8_t &control() { return TCCR2A; }
+    static volatile uint8_t &compare() { return OCR2A; }
+    static const uint8_t kConnect = _BV(COM2A1);
+};
+
+template <>
+struct StaticPWM<kOC2B>
+{
+    static volatile uint8_t &control() { return TCCR2A; }
+    static volatile uint8_t &compare() { return OCR2B; }
+    static const uint8_t kConnect = _BV(COM2B1);
+};
+#endif
+
+/**
+ * Represents a motor controlled by a TB6612FNG driver whose pin mapping is set at compile time
+ * @class
+ * @param {pin_size_t} IN1 - Arduino pin id connected to driver's AIN1/BIN1 input
+ * @param {pin_size_t} IN2 - Arduino pin id connected to driver's AIN2/BIN2 input
+ * @param {pin_size_t} PWM - Arduino pin id connected to driver's PWMA/PWMB input
+ * @note The class doesn't store the pin mapping: its objects only hold the MotorInterface virtual table pointer.
+ *  On ATmega328P/168 based Arduinos every operation is compiled into a few port and timer register writes
+ */
+template <pin_size_t IN1, pin_size_t IN2, pin_size_t PWM>
+class StaticMotor : public MotorInterface
+{
+    static_assert(IN1 != IN2 && IN1 != PWM && IN2 != PWM, "StaticMotor pins must be different");
+#if defined(STATIC_MOTOR_AVR_PORTS)
+    static_assert(staticPinPort(IN1) != 0 && staticPinPort(IN2) != 0, "StaticMotor IN1 and IN2 must be digital pins");
+    static_assert(staticPinPWMChannel(PWM) != kNoPWMChannel, "StaticMotor PWM must be a PWM pin (3, 5, 6, 9, 10 or 11)");
+#else
+#if defined(NUM_DIGITAL_PINS)
+    static_assert(IN1 < NUM_DIGITAL_PINS && IN2 < NUM_DIGITAL_PINS && PWM < NUM_DIGITAL_PINS, "StaticMotor pins must be digital pins");
+#endif
+#if defined(__AVR__) && defined(digitalPinHasPWM)
+    // Other cores, like the SAMD ones, read the pin features from a table in RAM, unknown at compile time
+    static_assert(digitalPinHasPWM(PWM), "StaticMotor PWM must be a PWM pin");
+#endif
+#endif
+
+public:
+    /**
+     * Creates a motor controlled by a TB6612FNG driver
+     * @constructor
+     * @note The mapped Arduino pins will be initialized by this function
+     */
+    StaticMotor()
+    {
+#if defined(STATIC_MOTOR_AVR_PORTS)
+        StaticPort<staticPinPort(IN1)>::ddr() |= staticPinMask(IN1);
+        StaticPort<staticPinPort(IN2)>::ddr() |= staticPinMask(IN2);
+        StaticPort<staticPinPort(PWM)>::ddr() |= staticPinMask(PWM);
+#else
+        pinMode(IN1, OUTPUT);
+        pinMode(IN2, OUTPUT);
+        pinMode(PWM, OUTPUT);
+#endif
+    }
+
+    /**
+     * Runs the motor in a given direction at a given speed
+     * @param {Direction} direction - Motor rotation direction
+     * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+     */
+    void run(Direction direction, uint16_t speed) override
+    {
+        direction == Clockwise ? setInputs_(true, false) : setInputs_(false, true);
+
+        // Zero value is equivalent to performing a braking, so that
+        // value is not acceptable in this function
+        if (speed > 0)
+            setPWM_(scaleSpeed_(speed));
+    }
+
+    /**
+     * Stops the motor
+     */
+    void stop() override
+    {
+        setInputs_(false, false);
+        setPWM_(255);
+    }
+
+    /**
+     * Short-brakes the motor
+     */
+    void brake() override
+    {
+        setPWM_(0);
+        setInputs_(true, true);
+    }
+
+private:
+    /**
+     * Scales a 16-bit speed value to an 8-bit PWM duty cycle
+     * @param {uint16_t} speed - Speed to scale
+     * @returns {uint8_t} Duty cycle, equal to round(speed * 255 / 65535) computed in integer math
+     */
+    static uint8_t scaleSpeed_(uint16_t speed)
+    {
+        return ((uint32_t)speed * 65281 + 0x800000) >> 24;
+    }
+
+    /**
+     * Sets the driver IN1 and IN2 inputs
+     * @param {bool} in1High - True to set IN1 high, else false
+     * @param {bool} in2High - True to set IN2 high, else false
+     */
+    static void setInputs_(bool in1High, bool in2High)
+    {
+#if defined(STATIC_MOTOR_AVR_PORTS)
+        HalInterruptState interruptState = halDisableInterrupts();
+        if (staticPinPort(IN1) == staticPinPort(IN2))
+        {
+            // Both inputs are set with a single port write
+            volatile uint8_t &out = StaticPort<staticPinPort(IN1)>::out();
+            out = (out & ~(staticPinMask(IN1) | staticPinMask(IN2))) |
+                  (in1High ? staticPinMask(IN1) : 0) | (in2High ? staticPinMask(IN2) : 0);
+        }
+        else if (in1High)
+        {
+            // The input set low is written first, so the driver goes through the stop state
+            writePin_<IN2>(in2High);
+            writePin_<IN1>(true);
+        }
+        else
+        {
+            writePin_<IN1>(false);
+            writePin_<IN2>(in2High);
+        }
+        halRestoreInterrupts(interruptState);
+#else
+        if (in1High)
+        {
+            halDigitalWrite(IN2, in2High);
+            halDigitalWrite(IN1, true);
+        }
+        else
+        {
+            halDigitalWrite(IN1, false);
+            halDigitalWrite(IN2, in2High);
+        }
+#endif
+    }
+
+    /**
+     * Sets the PWM duty cycle
+     * @param {uint8_t} duty - Duty cycle, from 0 to 255
+     */
+    static void setPWM_(uint8_t duty)
+    {
+#if defined(STATIC_MOTOR_AVR_PORTS)
+        typedef StaticPWM<staticPinPWMChannel(PWM)> Channel;
+        if (duty == 0 || duty == 255)
+        {
+            // As done by analogWrite, the timer output is disconnected at the extreme values
+            Channel::control() &= ~Channel::kConnect;
+            writePin_<PWM>(duty == 255);
+        }
+        else
+        {
+            Channel::compare() = duty;
+            Channel::control() |= Channel::kConnect;
+        }
+#else
+        halAnalogWrite(PWM, duty);
+#endif
+    }
+
+#if defined(STATIC_MOTOR_AVR_PORTS)
+    /**
+     * Sets a digital output
+     * @param {pin_size_t} pin - Arduino digital output
+     * @param {bool} high - True to set the output high, else false
+     */
+    template <pin_size_t pin>
+    static void writePin_(bool high)
+    {
+        if (high)
+            StaticPort<staticPinPort(pin)>::out() |= staticPinMask(pin);
+        else
+            StaticPort<staticPinPort(pin)>::out() &= ~staticPinMask(pin);
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,404 @@
+// Stepper.cpp
+// Implementation of the Stepper class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "Stepper.h"
+
+// Coil current of the microstepping modes: quarter sine wave sampled
+// every sixteenth step and scaled from 0 to 65535
+static const uint16_t kStepperSineTable[] PROGMEM = {
+    0, 6424, 12785, 19024, 25079, 30893, 36409, 41575,
+    46340, 50659, 54490, 57797, 60546, 62713, 64276, 65219,
+    65535};
+
+#if defined(STEPPER_AVR_TIMER2)
+// Timer2 prescaler of every clock select value, as a power of two
+static const uint8_t kTimer2PrescalerShift[] = {0, 0, 3, 5, 6, 7, 8, 10};
+#endif
+
+// Public functions definition
+
+/**
+ * Creates a bipolar stepper motor driven in full steps
+ * @constructor
+ * @param {Motor*} coilA - Driver channel connected to the motor coil A
+ * @param {Motor*} coilB - Driver channel connected to the motor coil B
+ */
+Stepper::Stepper(Motor *coilA, Motor *coilB) : Stepper(coilA, coilB, FullStep){};
+
+/**
+ * Creates a bipolar stepper motor driven in a given stepping mode
+ * @constructor
+ * @param {Motor*} coilA - Driver channel connected to the motor coil A
+ * @param {Motor*} coilB - Driver channel connected to the motor coil B
+ * @param {StepMode} stepMode - Stepping mode
+ */
+Stepper::Stepper(Motor *coilA, Motor *coilB, StepMode stepMode) : coilA_(coilA), coilB_(coilB), stepMode_(stepMode)
+{
+    tickFrequency_ = 0;
+    incrementPerStepRate_ = 0;
+    stepAccumulator_ = 0;
+    stepIncrement_ = 0;
+    stepRate_ = 0;
+    stepDirection_ = Clockwise;
+
+    // Every stepping mode starts at the position with both coils energized
+    phase_ = 8;
+    position_ = 0;
+    energized_ = false;
+
+    rampMap_ = NULL;
+}
+
+/**
+ * Starts ticking the stepper from a hardware timer interrupt
+ * @param {uint32_t} tickFrequency - Tick frequency, in Hertzs
+ * @returns {bool} True if a hardware timer was set up, false if tick() must be called from a user timer
+ */
+bool Stepper::begin(uint32_t tickFrequency)
+{
+    if (tickFrequency == 0)
+        return false;
+
+    HalInterruptState interruptState = halDisableInterrupts();
+    tickFrequency_ = tickFrequency;
+    bool timerSetUp = false;
+
+#if defined(STEPPER_AVR_TIMER2)
+    // The lowest prescaler whose compare value fits in 8 bits gives the closest frequency
+    uint8_t clockSelect;
+    uint32_t top = 0;
+    for (clockSelect = 1; clockSelect < sizeof(kTimer2PrescalerShift); clockSelect++)
+    {
+        top = ((F_CPU >> kTimer2PrescalerShift[clockSelect]) + tickFrequency / 2) / tickFrequency;
+        if (top <= 256)
+            break;
+    }
+    if (top >= 2 && top <= 256)
+    {
+        // Clear timer on compare match mode, ticking on every compare A match
+        TCCR2B = 0;
+        TCCR2A = _BV(WGM21);
+        TCNT2 = 0;
+        OCR2A = top - 1;
+        TIFR2 = _BV(OCF2A);
+        TIMSK2 |= _BV(OCIE2A);
+        TCCR2B = clockSelect;
+
+        uint32_t clock = F_CPU >> kTimer2PrescalerShift[clockSelect];
+        tickFrequency_ = (clock + top / 2) / top;
+        timerSetUp = true;
+    }
+#endif
+
+    incrementPerStepRate_ = 0xFFFFFFFF / tickFrequency_;
+    setStepRate_(stepRate_);
+    halRestoreInterrupts(interruptState);
+
+    return timerSetUp;
+}
+
+/**
+ * Returns the tick frequency
+ * @returns {uint32_t} Tick frequency, in Hertzs
+ */
+uint32_t Stepper::tickFrequency()
+{
+    return tickFrequency_;
+}
+
+/**
+ * Advances the stepper one tick
+ */
+void Stepper::tick()
+{
+    // The ramp step rate is updated once per millisecond
+    if (rampMap_ != NULL)
+    {
+        rampTickAccumulator_ += 1000;
+        while (rampTickAccumulator_ >= tickFrequency_ && rampMap_ != NULL)
+        {
+            rampTickAccumulator_ -= tickFrequency_;
+            updateRamp_();
+        }
+    }
+
+    // The motor steps whenever the phase accumulator overflows
+    uint32_t stepAccumulator = stepAccumulator_ + stepIncrement_;
+    bool stepDue = stepAccumulator < stepAccumulator_;
+    stepAccumulator_ = stepAccumulator;
+    if (stepDue)
+        step_();
+}
+
+/**
+ * Steps the motor in a given direction at a constant step rate
+ * @param {Direction} direction - Stepping direction
+ * @param {uint16_t} stepRate - Step rate, in steps of the stepping mode per second
+ */
+void Stepper::run(Direction direction, uint16_t stepRate)
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    rampMap_ = NULL;
+    stepDirection_ = direction;
+    setStepRate_(stepRate);
+    energize_();
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Starts a step rate ramp defined by a map with multiple points
+ * @param {Direction} direction - Stepping direction
+ * @param {SpinPoint[]} rampMap - Ramp map containing a list of points whose speeds are step rates, in steps per second
+ * @param {uint8_t} rampMapSize - Number of points contained in the ramp map
+ * @returns {const SpinPoint*} Pointer to the first ramp map point or null if the start operation cannot be executed
+ */
+const SpinPoint *Stepper::start(Direction direction, SpinPoint rampMap[], uint8_t rampMapSize)
+{
+    // Ramps are timed by the ticks, so the tick frequency must be set
+    if (tickFrequency_ == 0 || !checkRampMap_(rampMap, rampMapSize))
+        return NULL;
+
+    // The ramp state is shared with tick(), so it's set up at once
+    HalInterruptState interruptState = halDisableInterrupts();
+    stepDirection_ = direction;
+    rampMapSize_ = rampMapSize;
+    rampPointIndex_ = 0;
+    rampTime_ = 0;
+    rampTickAccumulator_ = 0;
+    rampMap_ = rampMap;
+    enterRampSegment_();
+    setStepRate_(rampMap[0].speed);
+    energize_();
+    halRestoreInterrupts(interruptState);
+
+    return &rampMap[0];
+}
+
+/**
+ * Returns if a ramp is in progress
+ * @returns {bool} True if a ramp is in progress, else false
+ */
+bool Stepper::ramping()
+{
+    return rampMap_ != NULL;
+}
+
+/**
+ * Aborts a ramp, keeping the motor stepping at the last step rate reached by the aborted ramp
+ */
+void Stepper::abort()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    rampMap_ = NULL;
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Stops stepping, keeping the coils energized so that the motor holds its position
+ */
+void Stepper::stop()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    rampMap_ = NULL;
+    setStepRate_(0);
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Stops stepping and de-energizes the coils
+ */
+void Stepper::release()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    rampMap_ = NULL;
+    setStepRate_(0);
+    coilA_->stop();
+    coilB_->stop();
+    energized_ = false;
+    halRestoreInterrupts(interruptState);
+}
+
+/**
+ * Returns the motor position
+ * @returns {long} Steps of the stepping mode done since the stepper creation, clockwise steps counting up
+ */
+long Stepper::position()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    long position = position_;
+    halRestoreInterrupts(interruptState);
+
+    return position;
+}
+
+/**
+ * Returns the current step rate
+ * @returns {uint16_t} Step rate, in steps of the stepping mode per second
+ */
+uint16_t Stepper::stepRate()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    uint16_t stepRate = stepRate_;
+    halRestoreInterrupts(interruptState);
+
+    return stepRate;
+}
+
+// Private functions definition
+
+/**
+ * Checks the integrity of a ramp map
+ * @param {SpinPoint[]} rampMap - Ramp map
+ * @param {uint8_t} rampMapSize - Number of points contained in the ramp map
+ * @returns {bool} True if the map is valid, else false
+ */
+bool Stepper::checkRampMap_(SpinPoint rampMap[], uint8_t rampMapSize)
+{
+#ifdef TB6612FNG_OMIT_SPINMAP_INTEGRITY_CHECK
+    return true;
+#else
+    // Maps with less than two points are not allowed, and the first map point time must be zero
+    if (rampMap == NULL || rampMapSize < 2 || rampMap[0].time != 0)
+        return false;
+
+    // Every map point time must be higher than its predecessor's
+    for (uint8_t i = 1; i < rampMapSize; i++)
+    {
+        if (rampMap[i].time <= rampMap[i - 1].time)
+            return false;
+    }
+
+    return true;
+#endif
+}
+
+/**
+ * Advances the ramp one millisecond
+ */
+void Stepper::updateRamp_()
+{
+    rampTime_++;
+
+    // Within a segment the step rate changes by its slope. Map point times are
+    // strictly increasing, so at most one point is reached per millisecond
+    if (rampTime_ < rampMap_[rampPointIndex_ + 1].time)
+    {
+        rampRate_ = rampDescending_ ? rampRate_ - rampSlope_ : rampRate_ + rampSlope_;
+        setStepRate_(rampRate_ >> 16);
+        return;
+    }
+
+    rampPointIndex_++;
+    setStepRate_(rampMap_[rampPointIndex_].speed);
+    if (rampPointIndex_ == rampMapSize_ - 1)
+    {
+        // Last map point reached: the motor keeps stepping at its step rate
+        rampMap_ = NULL;
+        return;
+    }
+
+    enterRampSegment_();
+}
+
+/**
+ * Calculates the step rate slope of the ramp segment starting at the last reached map point
+ * @note This is the only division done while ramping, once per map segment
+ */
+void Stepper::enterRampSegment_()
+{
+    const SpinPoint *startPoint = &rampMap_[rampPointIndex_];
+    const SpinPoint *endPoint = &rampMap_[rampPointIndex_ + 1];
+
+    // The step rate starts at one half, so that its integer part is rounded
+    rampRate_ = ((uint32_t)startPoint->speed << 16) | 0x8000;
+    rampDescending_ = endPoint->speed < startPoint->speed;
+    uint32_t speedIncrement = rampDescending_ ? startPoint->speed - endPoint->speed : endPoint->speed - startPoint->speed;
+    rampSlope_ = (speedIncrement << 16) / (endPoint->time - startPoint->time);
+}
+
+/**
+ * Sets the step rate, as the phase accumulator increment per tick
+ * @param {uint16_t} stepRate - Step rate, in steps of the stepping mode per second
+ */
+void Stepper::setStepRate_(uint16_t stepRate)
+{
+    stepRate_ = stepRate;
+
+    // Step rates from half the tick frequency on step on every other tick
+    if (tickFrequency_ == 0)
+        stepIncrement_ = 0;
+    else
+        stepIncrement_ = 2 * (uint32_t)stepRate < tickFrequency_ ? stepRate * incrementPerStepRate_ : 0x80000000;
+}
+
+/**
+ * Does a step in the current stepping direction
+ */
+void Stepper::step_()
+{
+    uint8_t stride = 16 / stepMode_;
+    if (stepDirection_ == Clockwise)
+    {
+        phase_ = (phase_ + stride) & kPhaseMask;
+        position_++;
+    }
+    else
+    {
+        phase_ = (phase_ - stride) & kPhaseMask;
+        position_--;
+    }
+
+    writeCoils_();
+}
+
+/**
+ * Energizes the coils at the current position, if they are not energized
+ */
+void Stepper::energize_()
+{
+    if (energized_)
+        return;
+
+    writeCoils_();
+    energized_ = true;
+}
+
+/**
+ * Sets the coil currents of the current position
+ * @note Coil A current follows the cosine of the position in the electrical cycle, and coil B current its sine
+ */
+void Stepper::writeCoils_()
+{
+    writeCoil_(coilA_, phase_ + 16);
+    writeCoil_(coilB_, phase_);
+}
+
+/**
+ * Sets the current of a coil
+ * @param {Motor*} coil - Driver channel connected to the coil
+ * @param {uint8_t} phase - Position in the electrical cycle, in sixteenth steps, whose sine sets the coil current
+ */
+void Stepper::writeCoil_(Motor *coil, uint8_t phase)
+{
+    phase &= kPhaseMask;
+
+    // The coil current is zero at both zero crossings of the sine, and changes
+    // its direction on the second half of the cycle
+    uint16_t current;
+    if ((phase & 31) == 0)
+        current = 0;
+    else if (stepMode_ < QuarterStep)
+        current = 65535;
+    else
+    {
+        uint8_t index = phase & 15;
+        current = halReadFlashWord(&kStepperSineTable[phase & 16 ? 16 - index : index]);
+    }
+
+    if (current == 0)
+        coil->stop();
+    else
+        coil->run(phase & 32 ? CounterClockwise : Clockwise, current);
+}
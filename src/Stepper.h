@@ -0,0 +1,192 @@
+// Stepper.h
+// Header file for Stepper class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef STEPPER_H
+#define STEPPER_H
+
+#include "Spinner.h"
+
+#if defined(__AVR__) && defined(TCCR2A) && defined(OCIE2A)
+// Steps ticked by the Timer2 compare A interrupt
+#define STEPPER_AVR_TIMER2
+#endif
+
+/**
+ * Stepping modes, valued as the steps per full step
+ * @enum
+ * @note Full and half steps drive the energized coils at full current. Microsteps
+ *  set the coil currents from a sine table, keeping the motor torque even
+ */
+enum StepMode
+{
+    FullStep = 1,
+    HalfStep = 2,
+    QuarterStep = 4,
+    EighthStep = 8,
+    SixteenthStep = 16
+};
+
+/**
+ * Bipolar stepper motor driven by both channels of a TB6612FNG driver, stepped from a periodic timer interrupt
+ * @class
+ * @note Steps are generated by a phase accumulator advanced on every tick, so the step times are
+ *  set by the tick frequency alone and their jitter is at most a tick period
+ */
+class Stepper
+{
+public:
+    /**
+     * Creates a bipolar stepper motor driven in full steps
+     * @constructor
+     * @param {Motor*} coilA - Driver channel connected to the motor coil A
+     * @param {Motor*} coilB - Driver channel connected to the motor coil B
+     */
+    Stepper(Motor *coilA, Motor *coilB);
+
+    /**
+     * Creates a bipolar stepper motor driven in a given stepping mode
+     * @constructor
+     * @param {Motor*} coilA - Driver channel connected to the motor coil A
+     * @param {Motor*} coilB - Driver channel connected to the motor coil B
+     * @param {StepMode} stepMode - Stepping mode
+     */
+    Stepper(Motor *coilA, Motor *coilB, StepMode stepMode);
+
+    /**
+     * Starts ticking the stepper from a hardware timer interrupt
+     * @param {uint32_t} tickFrequency - Tick frequency, in Hertzs. The highest step rate is half of it
+     * @returns {bool} True if a hardware timer was set up, false if tick() must be called from a user timer at the given frequency
+     * @note On AVR processors the Timer2 compare A interrupt is used, so the PWM outputs of Timer2
+     *  (pins 3 and 11 on an Arduino Uno, 9 and 10 on an Arduino Mega) are no longer available.
+     *  The interrupt service routine must be defined by placing the macro TB6612FNG_STEPPER_ISR(stepper) in the sketch
+     */
+    bool begin(uint32_t tickFrequency);
+
+    /**
+     * Returns the tick frequency
+     * @returns {uint32_t} Tick frequency, in Hertzs, as set up by begin(), or 0 if begin() wasn't called
+     */
+    uint32_t tickFrequency();
+
+    /**
+     * Advances the stepper one tick
+     * @note This function is addressed to be called from a periodic timer interrupt service routine
+     */
+    void tick();
+
+    /**
+     * Steps the motor in a given direction at a constant step rate
+     * @param {Direction} direction - Stepping direction
+     * @param {uint16_t} stepRate - Step rate, in steps of the stepping mode per second
+     * @note A running ramp will be aborted if this function is invoked
+     */
+    void run(Direction direction, uint16_t stepRate);
+
+    /**
+     * Starts a step rate ramp defined by a map with multiple points
+     * @param {Direction} direction - Stepping direction
+     * @param {SpinPoint[]} rampMap - Ramp map containing a list of points whose speeds are step rates, in steps per second
+     * @param {uint8_t} rampMapSize - Number of points contained in the ramp map
+     * @returns {const SpinPoint*} Pointer to the first ramp map point or null if the start operation cannot be executed
+     * @note begin() must be called first, since the ramp is timed by the ticks
+     * @note The ramp is calculated by tick() once per millisecond. Once its last point is reached
+     *  the motor keeps stepping at the last step rate
+     * @note Starting a ramp will abort a previous running ramp
+     */
+    const SpinPoint *start(Direction direction, SpinPoint rampMap[], uint8_t rampMapSize);
+
+    /**
+     * Returns if a ramp is in progress
+     * @returns {bool} True if a ramp is in progress, else false
+     */
+    bool ramping();
+
+    /**
+     * Aborts a ramp, keeping the motor stepping at the last step rate reached by the aborted ramp
+     */
+    void abort();
+
+    /**
+     * Stops stepping, keeping the coils energized so that the motor holds its position
+     * @note A running ramp will be aborted if this function is invoked
+     */
+    void stop();
+
+    /**
+     * Stops stepping and de-energizes the coils
+     * @note A running ramp will be aborted if this function is invoked
+     */
+    void release();
+
+    /**
+     * Returns the motor position
+     * @returns {long} Steps of the stepping mode done since the stepper creation, clockwise steps counting up
+     */
+    long position();
+
+    /**
+     * Returns the current step rate
+     * @returns {uint16_t} Step rate, in steps of the stepping mode per second
+     */
+    uint16_t stepRate();
+
+private:
+    // Electrical cycle positions: 4 quadrants of 16 sixteenth steps
+    static const uint8_t kPhaseMask = 63;
+
+    Motor *coilA_, *coilB_;
+    StepMode stepMode_;
+
+    uint32_t tickFrequency_;
+    // Step increment per step per second, ie, 2^32 / tickFrequency_
+    uint32_t incrementPerStepRate_;
+
+    // Phase accumulator, stepping the motor whenever it overflows, and its increment per tick
+    uint32_t stepAccumulator_;
+    uint32_t stepIncrement_;
+    uint16_t stepRate_;
+    Direction stepDirection_;
+
+    // Position in the electrical cycle, in sixteenth steps, and in steps of the stepping mode
+    uint8_t phase_;
+    volatile long position_;
+    bool energized_;
+
+    // Ramp map, or null if no ramp is in progress, the index of the last reached map point
+    // and the milliseconds elapsed since the ramp start, counted in ticks
+    SpinPoint *volatile rampMap_;
+    uint8_t rampMapSize_;
+    uint8_t rampPointIndex_;
+    uint16_t rampTime_;
+    uint32_t rampTickAccumulator_;
+
+    // Ramp step rate and its slope per millisecond, in Q16 fixed point
+    uint32_t rampRate_;
+    uint32_t rampSlope_;
+    bool rampDescending_;
+
+    static bool checkRampMap_(SpinPoint[], uint8_t);
+    void updateRamp_();
+    void enterRampSegment_();
+    void setStepRate_(uint16_t);
+    void step_();
+    void energize_();
+    void writeCoils_();
+    void writeCoil_(Motor *, uint8_t);
+};
+
+#if defined(STEPPER_AVR_TIMER2)
+/**
+ * Defines the Timer2 compare A interrupt service routine ticking a stepper
+ * @param {Stepper} stepper - Stepper object instance
+ */
+#define TB6612FNG_STEPPER_ISR(stepper) \
+    ISR(TIMER2_COMPA_vect)             \
+    {                                  \
+        (stepper).tick();              \
+    }
+#endif
+
+#endif
@@ -0,0 +1,204 @@
+// VelocityController.cpp
+// Implementation of the VelocityController class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "VelocityController.h"
+
+// Limit of the PID integral term, in Q8 fixed point: the integral alone can set the full speed
+static const long kIntegralLimit = 65535L << 8;
+
+// Public functions definition
+
+/**
+ * Creates a velocity controller
+ * @constructor
+ * @param {MotorInterface*} motor - Pointer to the controlled Motor (or StaticMotor) object instance
+ * @param {EncoderPinMap*} encoderPinMap - Pin mapping of the motor encoder
+ * @param {unsigned long} maxCountsPerSecond - Encoder counts per second matching the speed 65535
+ * @param {uint16_t} period - Control period, in milliseconds
+ */
+VelocityController::VelocityController(MotorInterface *motor, EncoderPinMap *encoderPinMap, unsigned long maxCountsPerSecond, uint16_t period) : motor_(motor)
+{
+    encoderPinMap_ = *encoderPinMap;
+    pinMode(encoderPinMap_.a, INPUT_PULLUP);
+    pinMode(encoderPinMap_.b, INPUT_PULLUP);
+
+    position_ = 0;
+    lastPosition_ = 0;
+    lastUpdateTime_ = halMicros();
+    period_ = (unsigned long)period * 1000;
+    countScale_ = 65535000000ULL / maxCountsPerSecond;
+
+    // Speed scale per encoder count over a control period, split into its integer part and its
+    // fraction in Q32 fixed point. The fraction is rounded up, so that multiplying by it floors
+    // like the division does for less than 2^32 / period counts per period
+    periodScale_ = countScale_ / period_;
+    periodScaleFraction_ = (uint32_t)((((countScale_ % period_) << 32) + period_ - 1) / period_);
+
+    enabled_ = false;
+    setpoint_ = 0;
+    velocity_ = 0;
+
+    tune(256, 0, 0);
+}
+
+/**
+ * Sets the PID controller gains
+ * @param {int16_t} kp - Proportional gain, in Q8.8 fixed point
+ * @param {int16_t} ki - Integral gain per control period, in Q8.8 fixed point
+ * @param {int16_t} kd - Derivative gain per control period, in Q8.8 fixed point
+ */
+void VelocityController::tune(int16_t kp, int16_t ki, int16_t kd)
+{
+    kp_ = kp;
+    ki_ = ki;
+    kd_ = kd;
+    integral_ = 0;
+    previousError_ = 0;
+}
+
+/**
+ * Sets the velocity setpoint and enables the closed loop control
+ * @param {Direction} direction - Motor rotation direction
+ * @param {uint16_t} speed - Motor rotation speed
+ */
+void VelocityController::run(Direction direction, uint16_t speed)
+{
+    setpoint_ = direction == Clockwise ? (long)speed : -(long)speed;
+    if (!enabled_)
+    {
+        // Start controlling from the current motor state
+        integral_ = 0;
+        previousError_ = setpoint_ - velocity_;
+        enabled_ = true;
+    }
+}
+
+/**
+ * Disables the closed loop control and stops the motor
+ */
+void VelocityController::stop()
+{
+    enabled_ = false;
+    setpoint_ = 0;
+    motor_->stop();
+}
+
+/**
+ * Disables the closed loop control and short-brakes the motor
+ */
+void VelocityController::brake()
+{
+    enabled_ = false;
+    setpoint_ = 0;
+    motor_->brake();
+}
+
+/**
+ * Runs a control step if the control period elapsed
+ * @returns {bool} True if a control step was run, else false
+ */
+bool VelocityController::update()
+{
+    unsigned long time = halMicros();
+    unsigned long elapsedTime = time - lastUpdateTime_;
+    if (elapsedTime < period_)
+        return false;
+    lastUpdateTime_ = time;
+
+    // Measure the velocity over the actual elapsed time, so a late step doesn't overestimate it
+    long position = readPosition_();
+    long counts = position - lastPosition_;
+    lastPosition_ = position;
+    if (elapsedTime == period_)
+    {
+        // On time step: multiply by the precomputed period scale instead of doing a 64-bit division
+        unsigned long countsMagnitude = counts < 0 ? -(unsigned long)counts : (unsigned long)counts;
+        unsigned long velocity = countsMagnitude * periodScale_ + (unsigned long)(((uint64_t)countsMagnitude * periodScaleFraction_) >> 32);
+        velocity_ = counts < 0 ? -(long)velocity : (long)velocity;
+    }
+    else
+    {
+        velocity_ = counts * (int64_t)countScale_ / (int64_t)elapsedTime;
+    }
+
+    if (!enabled_)
+        return true;
+
+    // PID step in Q8 fixed point, with a clamped integral term to prevent windup
+    long error = setpoint_ - velocity_;
+    int64_t integral = integral_ + (int64_t)ki_ * error;
+    if (integral > kIntegralLimit)
+        integral = kIntegralLimit;
+    else if (integral < -kIntegralLimit)
+        integral = -kIntegralLimit;
+    integral_ = integral;
+    int64_t output = ((int64_t)kp_ * error + integral_ + (int64_t)kd_ * (error - previousError_)) >> 8;
+    previousError_ = error;
+
+    // Drive the motor, whose speed ranges from 1 to 65535 in either direction
+    if (output >= 1)
+        motor_->run(Clockwise, output > 65535 ? 65535 : (uint16_t)output);
+    else if (output <= -1)
+        motor_->run(CounterClockwise, output < -65535 ? 65535 : (uint16_t)-output);
+    else
+        motor_->stop();
+
+    return true;
+}
+
+/**
+ * Counts an edge of the encoder channel A
+ */
+void VelocityController::encoderEdgeA()
+{
+    // Channel A leads channel B when rotating clockwise
+    if (halDigitalRead(encoderPinMap_.a) != halDigitalRead(encoderPinMap_.b))
+        position_++;
+    else
+        position_--;
+}
+
+/**
+ * Counts an edge of the encoder channel B
+ */
+void VelocityController::encoderEdgeB()
+{
+    if (halDigitalRead(encoderPinMap_.a) == halDigitalRead(encoderPinMap_.b))
+        position_++;
+    else
+        position_--;
+}
+
+/**
+ * Returns the motor velocity measured by the last control step
+ * @returns {long} Velocity, in the speed scale
+ */
+long VelocityController::velocity()
+{
+    return velocity_;
+}
+
+/**
+ * Returns the encoder position
+ * @returns {long} Encoder counts since the controller creation
+ */
+long VelocityController::position()
+{
+    return readPosition_();
+}
+
+// Private functions definition
+
+/**
+ * Reads the encoder position without being interrupted by the encoder interrupt service routines
+ * @returns {long} Encoder counts since the controller creation
+ */
+long VelocityController::readPosition_()
+{
+    HalInterruptState interruptState = halDisableInterrupts();
+    long position = position_;
+    halRestoreInterrupts(interruptState);
+    return position;
+}
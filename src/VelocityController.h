@@ -0,0 +1,127 @@
+// VelocityController.h
+// Header file for VelocityController class
+// Copyright (c) Vicente Gavara. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef VELOCITY_CONTROLLER_H
+#define VELOCITY_CONTROLLER_H
+
+#include "Motor.h"
+
+/**
+ * Encoder pin mapping
+ * @typedef {struct} EncoderPinMap
+ * @property {pin_size_t} a - Arduino digital input connected to the encoder channel A
+ * @property {pin_size_t} b - Arduino digital input connected to the encoder channel B
+ */
+typedef struct
+{
+    pin_size_t a;
+    pin_size_t b;
+} EncoderPinMap;
+
+/**
+ * Closed loop velocity controller of a motor with a quadrature encoder
+ * @class
+ * @note The controller is a motor itself: its run() function sets the velocity setpoint,
+ *  so a Spinner can spin the controller instead of the motor
+ */
+class VelocityController : public MotorInterface
+{
+public:
+    /**
+     * Creates a velocity controller
+     * @constructor
+     * @param {MotorInterface*} motor - Pointer to the controlled Motor (or StaticMotor) object instance
+     * @param {EncoderPinMap*} encoderPinMap - Pin mapping of the motor encoder
+     * @param {unsigned long} maxCountsPerSecond - Encoder counts per second matching the speed 65535
+     * @param {uint16_t} period - Control period, in milliseconds
+     * @note The encoder pins are initialized as inputs with pull-up
+     */
+    VelocityController(MotorInterface *motor, EncoderPinMap *encoderPinMap, unsigned long maxCountsPerSecond, uint16_t period);
+
+    /**
+     * Sets the PID controller gains
+     * @param {int16_t} kp - Proportional gain, in Q8.8 fixed point (256 is 1.0)
+     * @param {int16_t} ki - Integral gain per control period, in Q8.8 fixed point
+     * @param {int16_t} kd - Derivative gain per control period, in Q8.8 fixed point
+     */
+    void tune(int16_t kp, int16_t ki, int16_t kd);
+
+    /**
+     * Sets the velocity setpoint and enables the closed loop control
+     * @param {Direction} direction - Motor rotation direction
+     * @param {uint16_t} speed - Motor rotation speed, from 1 to 65535
+     */
+    void run(Direction direction, uint16_t speed) override;
+
+    /**
+     * Disables the closed loop control and stops the motor
+     */
+    void stop() override;
+
+    /**
+     * Disables the closed loop control and short-brakes the motor
+     */
+    void brake() override;
+
+    /**
+     * Runs a control step if the control period elapsed
+     * @returns {bool} True if a control step was run, else false
+     * @note This function must be called periodically, more often than the control period
+     */
+    bool update();
+
+    /**
+     * Counts an edge of the encoder channel A
+     * @note This function must be called from the channel A change interrupt service routine
+     */
+    void encoderEdgeA();
+
+    /**
+     * Counts an edge of the encoder channel B
+     * @note This function must be called from the channel B change interrupt service routine.
+     *  Counting the channel B edges doubles the encoder resolution, but it's optional
+     */
+    void encoderEdgeB();
+
+    /**
+     * Returns the motor velocity measured by the last control step
+     * @returns {long} Velocity, from -65535 to 65535 in the speed scale (positive when clockwise)
+     */
+    long velocity();
+
+    /**
+     * Returns the encoder position
+     * @returns {long} Encoder counts since the controller creation (increasing when clockwise)
+     */
+    long position();
+
+private:
+    MotorInterface *motor_;
+    EncoderPinMap encoderPinMap_;
+
+    volatile long position_;
+    long lastPosition_;
+    unsigned long lastUpdateTime_;
+    unsigned long period_;
+
+    // Speed scale microseconds per encoder count: a count per microsecond would be this speed
+    uint64_t countScale_;
+
+    // Speed scale per encoder count over an on time control period, integer part and Q32 fraction
+    unsigned long periodScale_;
+    uint32_t periodScaleFraction_;
+
+    bool enabled_;
+    long setpoint_;
+    long velocity_;
+
+    int16_t kp_, ki_, kd_;
+    long integral_;
+    long previousError_;
+
+    long readPosition_();
+};
+
+#endif
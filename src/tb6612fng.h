@@ -8,6 +8,15 @@
 
 #include "Driver.h"
 #include "Motor.h"
+#include "StaticMotor.h"
 #include "Spinner.h"
+#include "SpinnerScheduler.h"
+#include "SpinnerGroup.h"
+#include "SpinStream.h"
+#include "CompiledSpinMap.h"
+#include "SpinProfile.h"
+#include "VelocityController.h"
+#include "Stepper.h"
+#include "MotorCommandQueue.h"
 
 #endif
\ No newline at end of file